@@ -0,0 +1,44 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file benchmark.hpp */
+
+#include <cstddef>
+
+/*!
+ * \brief benchmarkRotate measures the throughput of rotate for every kernel supported by the processor
+ * \details Prints the number of rotor states per second for one state stepped by advance and for count independent
+ * states stepped by rotate_n. The kernel selected before is restored afterwards.
+ * \param count number of independent states stepped by rotate_n
+ */
+void benchmarkRotate(const size_t count);
+
+/*!
+ * \brief benchmarkSubstitute measures the throughput of the substitution for several key lengths
+ * \details For every kernel supported by the processor the version looping over the rotors is compared with the one
+ * unrolled for the key length. The kernel selected before is restored afterwards.
+ */
+void benchmarkSubstitute();
+
+/*!
+ * \brief benchmarkChaCha measures the throughput of the ChaCha keystream
+ * \details The bytes per second used from get(), which keeps one word per block, are compared with generate() for
+ * every kernel supported by the processor. The kernel selected before is restored afterwards.
+ */
+void benchmarkChaCha();
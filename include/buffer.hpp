@@ -0,0 +1,102 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file buffer.hpp */
+
+#include <cstddef>
+
+#include "threadpool.hpp"
+#include "types.hpp"
+
+/*!
+ * \brief allocateBytes allocates the memory for the data of a file
+ * \details With local placement explicit huge pages are tried first, then an anonymous mapping with transparent huge
+ * pages is requested. The pages are not touched, so the first thread writing to a page decides its NUMA node.
+ * Other platforms and the heap placement use malloc.
+ * \param size number of bytes
+ * \param placement heap or local
+ * \param pages set to the kind of pages backing the buffer
+ * \return pointer to the memory, must be released by freeBytes
+ */
+Byte* allocateBytes(const size_t size, const Placement placement, Pages& pages);
+
+/*!
+ * \brief freeBytes releases memory allocated by allocateBytes
+ * \param bytes pointer returned by allocateBytes
+ * \param size number of bytes requested
+ * \param pages kind of pages returned by allocateBytes
+ */
+void freeBytes(Byte* bytes, const size_t size, const Pages pages);
+
+/*!
+ * class Buffer
+ * \brief owns memory allocated by allocateBytes and releases it by freeBytes, also if an exception is thrown
+ */
+class Buffer {
+private:
+  Byte* p_bytes;  /**< memory returned by allocateBytes */
+  size_t p_size;  /**< number of bytes requested */
+  Pages p_pages;  /**< kind of pages backing the memory */
+
+public:
+  /*!
+   * \brief Buffer allocates the memory by allocateBytes
+   * \param size number of bytes
+   * \param placement heap or local
+   */
+  Buffer(const size_t size, const Placement placement);
+
+  Buffer(Buffer&& other) noexcept;
+  Buffer(const Buffer&)            = delete;
+  Buffer& operator=(const Buffer&) = delete;
+
+  /*!
+   * \brief bytes returns the memory
+   * \return pointer to the first byte
+   */
+  Byte* bytes() const noexcept;
+
+  /*!
+   * \brief pages returns how the memory has been allocated
+   * \return kind of pages
+   */
+  Pages pages() const noexcept;
+
+  /*!
+   * \brief ~Buffer releases the memory
+   */
+  ~Buffer();
+};
+
+/*!
+ * \brief firstTouch faults in every task range of the data in the thread pool
+ * \details The ranges are submitted in the same order as the tasks of the encryption, so the same threads will
+ * mostly work on them later.
+ * \param bytes data to be placed
+ * \param pool pool with pinned threads
+ * \param taskSize number of bytes per task
+ */
+void firstTouch(Data& bytes, ThreadPool& pool, const size_t taskSize);
+
+/*!
+ * \brief pagesName returns a readable name of the kind of pages
+ * \param pages kind of pages
+ * \return name for the log
+ */
+const char* pagesName(const Pages pages);
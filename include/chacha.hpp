@@ -19,26 +19,56 @@
 
 /*! \file chacha.hpp */
 
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 
 #include <csprng.hpp>
 
+#include "kernels.hpp"
+
+// implementation related to:
+// https://stackoverflow.com/questions/776508/best-practices-for-circular-shift-rotate-operations-in-c
+constexpr uint32_t rotleft(const uint32_t integer, unsigned int count) {
+  const unsigned int cutof = 31;
+  count &= cutof;  // shifts larger than 31 bits are not needed in a 32 bit integer
+  return (integer << count | integer >> ((-count) & cutof));
+}
+
+constexpr void quaterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+  a += b;
+  d ^= a;
+  d = rotleft(d, 16);
+
+  c += d;
+  b ^= c;
+  b = rotleft(b, 12);
+
+  a += b;
+  d ^= a;
+  d = rotleft(d, 8);
+
+  c += d;
+  b ^= c;
+  b = rotleft(b, 7);
+}
+
 /*!
  * class ChaCha
  * \brief implemnts the csprng ChaCha
  * \details compare implementation to: BERNSTEIN, Daniel J., et al. ChaCha, a variant of Salsa20. In: Workshop record of
  * SASC. 2008. S. 3-5.
+ * All members are constexpr, so rotors can be generated by the compiler.
  */
 class ChaCha {
 private:
-  uint32_t pState[16];                     /**< compile time fixed value according to Bernsteins algorithm **/
-  const unsigned int DOUBLE_ROUNDS   = 10; /**< constant for number of rounds **/
-  const uint32_t expand_32_byte_k[4] = {
+  uint32_t pState[16] = {};                         /**< state according to Bernsteins algorithm **/
+  static constexpr unsigned int DOUBLE_ROUNDS = 10; /**< constant for number of rounds **/
+  static constexpr uint32_t expand_32_byte_k[4] = {
     0x61707865, 0x3320646e, 0x79622d32, 0x6b206574}; /**< nothing in the sleeve number **/
 
 public:
-  ChaCha() = default;
+  constexpr ChaCha() = default;
 
   /*!
    * \brief init sets the initial state
@@ -46,24 +76,91 @@ public:
    * The following 12 * 4 bytes are set to the given seed.
    * \param seed has to be 48 byte to initialize the state of the chacha algorithm
    */
-  void init(const uint32_t* seed);
+  constexpr void init(const uint32_t* seed) {
+    for (unsigned int i = 0; i < 4; ++i) {
+      pState[i] = expand_32_byte_k[i];
+    }
+    for (unsigned int i = 0; i < 12; ++i) {
+      pState[4 + i] = seed[i];
+    }
+  }
+
+  /*!
+   * \brief block computes the 64 bytes of the current block by computing 2 * DOUBLE_ROUNDS rounds
+   * \param output 16 words of the block, the counter isn't ticked
+   */
+  constexpr void block(uint32_t* output) const {
+    uint32_t workingState[16] = {};
+    for (unsigned int i = 0; i < 16; ++i) {
+      workingState[i] = pState[i];
+    }
+
+    for (unsigned int i = 0; i < DOUBLE_ROUNDS; ++i) {
+      // uneven rounds
+      quaterRound(workingState[0], workingState[4], workingState[8], workingState[12]);
+      quaterRound(workingState[1], workingState[5], workingState[9], workingState[13]);
+      quaterRound(workingState[2], workingState[6], workingState[10], workingState[14]);
+      quaterRound(workingState[3], workingState[7], workingState[11], workingState[15]);
+
+      // even rounds
+      quaterRound(workingState[0], workingState[5], workingState[10], workingState[15]);
+      quaterRound(workingState[1], workingState[6], workingState[11], workingState[12]);
+      quaterRound(workingState[2], workingState[7], workingState[8], workingState[13]);
+      quaterRound(workingState[3], workingState[4], workingState[9], workingState[14]);
+    }
+
+    // add original state to current
+    for (unsigned int i = 0; i < 16; ++i) {
+      output[i] = workingState[i] + pState[i];
+    }
+  }
 
   /*!
    * \brief get computes the 64 bytes by computing 2 * DOUBLE_ROUNDS rounds and ticks the counter once
    * \return in contrary to normal use of chacha only 1 32-bit integer is returned
    */
-  uint32_t get();
+  constexpr uint32_t get() {
+    uint32_t output[16] = {};
+    block(output);
 
-  ~ChaCha() = default;
+    // increase counter by one
+    ++pState[12];
+
+    // return, theoreticly all 64 byte
+    return output[0];
+  }
+
+  /*!
+   * \brief generate writes the whole keystream of the following blocks
+   * \details The blocks are computed several at once by the selected kernel. The first 4 bytes of every block are
+   * the word get() would return for it. The counter is ticked once per started block, the rest of a partial last
+   * block is discarded.
+   * \param buffer receives the keystream
+   * \param length number of bytes to write
+   */
+  void generate(Byte* buffer, const size_t length);
 };
 
 /*!
  * \brief expandSeed
+ * \details The words are the bytes of src in little endian order, like copying src on the supported platforms.
  * \param seed pointer of 48 byte length were the expanded seed is written to
  * \param src given seed will be repeated until it's length is 48 byte
- * \param length gives the number of bytes in the seed
  */
-void expandSeed(uint32_t* seed, const uint64_t src);
+constexpr void expandSeed(uint32_t* seed, const uint64_t src) {
+  for (unsigned int i = 0; i < 12; ++i) {
+    seed[i] = static_cast<uint32_t>(src >> (32 * (i % 2)));
+  }
+}
+
+/*!
+ * \brief chachaVariant returns the implementation of the ChaCha block function for a kernel
+ * \details The implementations compute count consecutive blocks of the 16 words of state, the counter in word 12
+ * wraps like the one of get(), and write them one after another to output.
+ * \param kernel the kernel of interest
+ * \return function computing 1, 4 or 8 blocks per iteration
+ */
+ChaChaFunction chachaVariant(const Kernel kernel);
 
 /*!
  * \brief generateSeed invokes the csprng library in order to get a seed
@@ -0,0 +1,92 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file checkpoint.hpp */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "constants.hpp"
+#include "options.hpp"
+#include "types.hpp"
+
+/*!
+ * class CheckpointCache
+ * \brief stores the rotor state every interval positions, so the rotate chain doesn't need to be walked again
+ * \details The rotor states only depend on the initial rotorShifts of the key. Hence the cache file is named by a
+ * fingerprint of them and is shared by the keys for encryption and decryption. Checkpoint k is the state after
+ * k * interval calls of rotate. Be aware that the cache files contain key material! They are created readable by the
+ * owner only and carry a checksum of the checkpoints, damaged files are ignored like missing ones.
+ * If the interval is 0 the cache doesn't touch any file and just walks from the last requested position.
+ */
+class CheckpointCache {
+private:
+  Byte p_cursor[MAX_KEYLENGTH];     /**< rotor state at position p_cursorPosition */
+  size_t p_cursorPosition;          /**< position of the last state that has been computed */
+  size_t p_interval;                /**< number of positions between two checkpoints */
+  size_t p_sizeCap;                 /**< maximal size of the cache directory in bytes */
+  std::string p_directory;          /**< directory of the cache files */
+  std::string p_filename;           /**< name of the cache file for this key */
+  std::vector<Byte> p_checkpoints;  /**< all known checkpoints, each MAX_KEYLENGTH bytes */
+  size_t p_loaded;                  /**< number of checkpoints read from the cache file */
+  size_t p_requested;               /**< number of rotations a plain walk would have needed */
+  size_t p_walked;                  /**< number of rotations actually computed */
+
+  void load(const Byte* rotorShifts);
+  void evict() const;
+
+public:
+  /*!
+   * \brief CheckpointCache prepares the cache and reads the cache file if there is one
+   * \param rotorShifts initial rotor state of the key
+   * \param options provides interval, size limit and directory of the cache
+   */
+  CheckpointCache(const Byte* rotorShifts, const CryptOptions& options);
+
+  /*!
+   * \brief seek computes the rotor state at given position
+   * \details Starts from the nearest checkpoint or the last sought position and records new checkpoints while
+   * walking. It's fastest when called with increasing positions.
+   * \param rotorShifts MAX_KEYLENGTH bytes where the state is written to
+   * \param position number of rotations applied to the initial state
+   */
+  void seek(Byte* rotorShifts, const size_t position);
+
+  /*!
+   * \brief save writes new checkpoints to the cache file and evicts the oldest cache files exceeding the size limit
+   */
+  void save();
+
+  /*!
+   * \brief printStats prints how many rotations have been saved by the cache
+   */
+  void printStats() const;
+
+  ~CheckpointCache() = default;
+};
+
+/*!
+ * \brief fingerprint computes a 64 bit FNV-1a hash
+ * \param data bytes to be hashed
+ * \param length number of bytes
+ * \return the hash value
+ */
+uint64_t fingerprint(const Byte* data, const size_t length);
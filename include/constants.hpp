@@ -31,6 +31,38 @@ inline const std::string STD_KEY_DIR     = "keys/";
 inline const unsigned int STD_KEY_LENGTH = 10;
 inline const std::string STD_ROT_DIR     = "rotors/";
 inline const std::string VALID_ROT_NAMES = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+/** File packing all rotors of a directory. */
+inline const std::string ROTOR_BUNDLE    = "rotors.bundle";
+/** Rotor directory standing for the rotors compiled into the binary. */
+inline const std::string EMBEDDED_ROTORS = "@embedded";
+inline const std::string STD_CACHE_DIR   = "cache/";
+inline const size_t STD_CACHE_SIZE       = 64 << 20;  /**< default limit for the checkpoint cache in bytes */
+inline const size_t STD_CHUNK_SIZE       = 1 << 20;   /**< default chunk size of the chunked file format */
+inline const std::string FORMAT_MAGIC    = "TUR2";    /**< first bytes of a file in the chunked format */
+inline const size_t HEADER_SIZE          = 24;        /**< magic, version, chunk size and original size */
+inline const size_t STD_RING_DEPTH       = 4;         /**< default number of blocks in a pipeline ring buffer */
+inline const size_t STD_BLOCK_SIZE       = 2048;      /**< default number of positions per pipeline block */
+inline const size_t STD_BENCH_STATES     = 256;       /**< default number of states stepped by the benchmark */
+inline const size_t STD_CYCLE_ITERATIONS = 1e12;      /**< default limit of the cycle search */
+inline const size_t MAX_KEY_CANDIDATES   = 1000;      /**< number of keys tested by genKey before giving up */
+inline const size_t FAST_PATH_BYTES      = 1 << 16;   /**< smaller files are processed by a single thread */
+inline const size_t CALIBRATION_BYTES    = 1 << 14;   /**< bytes processed to measure the speed of the kernel */
+inline const double MIN_TASK_DURATION    = 2e-4;      /**< lower limit of the work per thread pool task in seconds */
+inline const size_t TASKS_PER_THREAD     = 8;         /**< number of tasks per thread for balancing the load */
+inline const size_t MAX_THREADS_FACTOR   = 16;        /**< upper limit of --threads per available processor */
+/** Bytes holding the rotors of a key followed by the tables the kernels derive from them. */
+inline const size_t ROTOR_MEMORY         = 2 * 256 * MAX_KEYLENGTH;
+inline const size_t PAGE_SIZE            = 4096;      /**< smallest page size, distance of the first touches */
+inline const size_t HUGE_PAGE_SIZE       = 1 << 21;   /**< size of explicit huge pages */
+inline const size_t URING_WINDOWS        = 8;         /**< number of windows in flight with io_uring */
+inline const size_t STD_URING_WINDOW     = 1 << 22;   /**< default window size of the io_uring backend */
+inline const size_t MAX_URING_TRANSFER   = 1 << 30;   /**< largest window of the io_uring backend */
+inline const size_t DIRECT_ALIGNMENT     = 4096;      /**< alignment of offsets, lengths and buffers with O_DIRECT */
+inline const size_t STD_DIRECT_MEMORY    = 1 << 25;   /**< default memory cap of the streaming mode with O_DIRECT */
+inline const size_t MAX_DIRECT_TRANSFER  = 1 << 22;   /**< largest single request with O_DIRECT */
+inline const std::string PIPE_NAME       = "-";       /**< file name standing for stdin or stdout */
+inline const size_t STD_PIPE_MEMORY      = 1 << 25;   /**< default memory cap of the pipe mode */
+inline const size_t BATCH_FILE_COST      = 1 << 14;   /**< work of opening a file of a batch in bytes of data */
 
 #ifdef _WIN32
 inline const std::string EXECUTE = PROJECTNAME + ".exe";
@@ -0,0 +1,99 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file directfile.hpp */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "types.hpp"
+
+/*!
+ * class DirectFile
+ * \brief file read and written with O_DIRECT, so the data doesn't pass through the page cache
+ * \details O_DIRECT needs offsets, lengths and addresses aligned to the logical block size of the device. Every
+ * transfer goes through an aligned staging buffer, which is reused by all requests. Reads fetch the aligned blocks
+ * around the requested range. The partial blocks at the ends of a write are written through a second, buffered
+ * descriptor, because writing them directly would overwrite the neighbouring bytes. Only available on systems with
+ * O_DIRECT and only on file systems supporting it, see valid().
+ */
+class DirectFile {
+private:
+  int p_direct;           /**< descriptor opened with O_DIRECT, -1 if that failed */
+  int p_buffered;         /**< descriptor for the partial blocks at the ends of a write */
+  int p_error;            /**< errno of the failed open */
+  Byte* p_stage;          /**< staging buffer aligned to DIRECT_ALIGNMENT */
+  size_t p_stageSize;     /**< size of the staging buffer, a multiple of DIRECT_ALIGNMENT */
+  size_t p_directBytes;   /**< bytes transferred with O_DIRECT */
+  size_t p_bufferedBytes; /**< bytes of partial blocks written through the page cache */
+  double p_seconds;       /**< time spent in the transfers */
+  std::string p_filename; /**< name of the file for error messages */
+
+public:
+  /*!
+   * \brief DirectFile opens a file bypassing the page cache
+   * \param filename name of the file
+   * \param write false opens an existing file for reading, true creates or truncates the file for writing
+   * \param transfer largest number of bytes moved by a single request, rounded up to DIRECT_ALIGNMENT
+   */
+  DirectFile(const char* filename, const bool write, const size_t transfer);
+
+  DirectFile(const DirectFile&)            = delete;
+  DirectFile& operator=(const DirectFile&) = delete;
+
+  /*!
+   * \brief valid tells whether the file could be opened with O_DIRECT
+   * \return false if the system or the file system doesn't support O_DIRECT
+   */
+  bool valid() const noexcept { return p_direct >= 0; }
+
+  /*!
+   * \brief error returns the reason why the file couldn't be opened with O_DIRECT
+   * \return errno of the failed open
+   */
+  int error() const noexcept { return p_error; }
+
+  /*!
+   * \brief read reads exactly length bytes starting at offset
+   * \param bytes destination, needs no alignment
+   * \param length number of bytes
+   * \param offset position in the file
+   */
+  void read(Byte* bytes, const size_t length, const uint64_t offset);
+
+  /*!
+   * \brief write writes exactly length bytes starting at offset
+   * \param bytes source, needs no alignment
+   * \param length number of bytes
+   * \param offset position in the file
+   */
+  void write(const Byte* bytes, const size_t length, const uint64_t offset);
+
+  /*!
+   * \brief printBandwidth prints the bytes transferred and the bandwidth achieved
+   * \param operation "Read" or "Wrote" for the log line
+   */
+  void printBandwidth(const char* operation) const;
+
+  /*!
+   * \brief ~DirectFile frees the staging buffer and closes the file
+   */
+  ~DirectFile();
+};
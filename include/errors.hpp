@@ -138,6 +138,30 @@ private:
                              struggling to create */
 };
 
+/*!
+ * \class FileAccessFailed
+ * \brief The class FileAccessFailed is designed to handle errors when reading from or writing to an open file fails.
+ */
+class FileAccessFailed : public TuringaError {
+public:
+  /*!
+   * \brief FileAccessFailed
+   * \param function the name of the function where the error occurs as string
+   * \param filename name of the file
+   * \param operation read or write
+   */
+  FileAccessFailed(std::string function, std::string filename, std::string operation);
+  /*!
+   * \brief prints out the error message to the console
+   * \details prints the operation, the name of the file and the name of the function where the error occured
+   */
+  const char* what() const noexcept override;
+
+private:
+  std::string p_filename;  /**< name of the file */
+  std::string p_operation; /**< operation which failed */
+};
+
 /*!
  * \class NoKey
  * \brief The class NoKey s designed to handle the error of not existing keys
@@ -185,6 +209,15 @@ void syntaxGenerateKey();
  * \details explaines the arguments needed for rotor generation
  */
 void syntaxGenerateRotors();
+/*!
+ * \brief syntaxBenchmark prints detailed syntax advices for the benchmark
+ */
+void syntaxBenchmark();
+/*!
+ * \brief syntaxBatch prints detailed syntax advices for encrypting many files at once
+ */
+void syntaxBatch();
+
 /*!
  * \brief syntaxHelp prints a hint how syntax
  * \details explaines how to get only specific syntax advices
@@ -24,6 +24,7 @@
 
 #include "constants.hpp"
 #include "errors.hpp"
+#include "options.hpp"
 #include "types.hpp"
 
 /** \def Assuming we are compiling with at least gcc 8.0 we can use std::filesystem and it's c++17
@@ -87,8 +88,27 @@ inline void ignore_byte(std::istream& myfile) {
  * \param outputfilename file where the output should be saved
  * \param rotDirectory directory which contains the rotorfiles used by the key
  * \param key defines the encryption
+ * \param options optional settings given by --name=value arguments
  */
-void handleCrypt(const char* filename, const char* outputfilename, const char* rotDirectory, TuringaKey key);
+void handleCrypt(
+  const char* filename, const char* outputfilename, const char* rotDirectory, TuringaKey key,
+  const CryptOptions& options);
+
+/*!
+ * \brief handleBatch encrypts or decrypts many files with one key and one set of rotors
+ * \details The files are either all regular files below a directory or listed line by line in a manifest. The outputs
+ * keep their paths relative to the directory or the current one, encryption appends .tur and decryption removes it.
+ * Large files are split between all threads of the pool one after the other, the small ones are processed whole by
+ * one thread each. Only the totals are printed.
+ * \param source directory or manifest listing the files
+ * \param outputDirectory directory where the outputs are written
+ * \param rotDirectory directory which contains the rotorfiles used by the key
+ * \param key defines the encryption
+ * \param options optional settings given by --name=value arguments
+ */
+void handleBatch(
+  const char* source, const char* outputDirectory, const char* rotDirectory, TuringaKey key,
+  const CryptOptions& options);
 
 /*!
  * \brief testForExistence tests a file of given name exists or not
@@ -98,30 +118,22 @@ void handleCrypt(const char* filename, const char* outputfilename, const char* r
 bool testForExistence(const char* filename);
 
 /*!
- * \brief findRotors detects the existence of rotorfiles
+ * \brief findRotors detects the existence of rotorfiles and of rotors in the bundle
  * \param path specifies the directory to search for rotors
  * \return list of rotors found at the location given by path
  */
 std::string findRotors(std::string path = STD_ROT_DIR);
 
 /*!
- * \brief reads the content of file into bytes
- * \details In case the direction is encrypt the fileShift from TuringaKey will be applied.
- * \param bytes a struct of type Data storing the files information
- * \param filename name of the file to be read
- * \param key the TuringaKey which will be applied by reading the file
- */
-void read_file(Data& bytes, const char* filename, const TuringaKey& key);
-
-/*!
- * \brief writes the data from bytes to into a file
- * \details In case the direction is decrypt the invers of the fileShift from TuringaKey will be
- * applied.
- * \param bytes a struct of type Data storing the files information
- * \param filename name of the file to be written
- * \param key the TuringaKey which will be apllied by writing the file
+ * \brief readHeader detects the format of an encrypted file
+ * \details A file is considered to be in the chunked format if it starts with the magic bytes, has a known version and
+ * its size matches the original size stored in the header. A framed stream has the original size 0. Otherwise it's a
+ * file in the legacy format.
+ * \param filename name of the file to be examined
+ * \param verbose print the format detected
+ * \return the header of the file, for a legacy file the original size is the file size
  */
-void write_file(const Data& bytes, const char* filename, const TuringaKey& key);
+FileHeader readHeader(const char* filename, const bool verbose = true);
 
 /*!
  * \brief reads a TuringaKey from given file
@@ -132,6 +144,7 @@ void write_file(const Data& bytes, const char* filename, const TuringaKey& key);
  * The next 32 bytes contain the initial rotorshifts where the rotation starts.
  * The next bytes store the file shift.
  * Finally the last bytes specify the used rotors.
+ * Keys written by stampRotorHash end with the 8 byte fingerprint of their rotor set, older keys don't.
  */
 TuringaKey readTuringaKey(const char* filename);
 
@@ -144,12 +157,32 @@ void writeTuringaKey(const std::string filename, const TuringaKey& key);
 
 /*!
  * \brief loads the rotors from files in rotDirectory
- * \details If a rotor is used multiple times it's data will be loaded multiple times by this
- * function.
+ * \details For the directory EMBEDDED_ROTORS the rotors compiled into the binary are used. Otherwise the rotors
+ * are copied from the bundle of the directory if there is one, the others are read from their files. A rotor
+ * used multiple times is looked up once and copied to its other positions.
  * In case the direction is decrypt the invers rotors will be loaded and they will be loaded in
  * reverse order.
  * \param key determines which rotors should be loaded
+ * If the key carries the fingerprint of its rotor set, rotors with a different fingerprint are rejected. A rotor file
+ * newer than the bundle is read instead of the table in the bundle.
  * \param rotDirectory specifies the directory where the rotor files are stored
- * \return an array which containes the data from the loaded rotors
+ * \return ROTOR_MEMORY bytes containing the loaded rotors followed by the tables of deriveRotorTables
  */
 Byte* loadRotors(const TuringaKey& key, const char* rotDirectory);
+
+/*!
+ * \brief rotorSetHash computes the fingerprint of the rotors of a key
+ * \details The fingerprint covers the permutations in the order of the key, so a key and its inverse get the same one.
+ * \param key key the rotors have been loaded for
+ * \param rotors rotors returned by loadRotors
+ * \return 64 bit FNV-1a hash
+ */
+uint64_t rotorSetHash(const TuringaKey& key, const Byte* rotors);
+
+/*!
+ * \brief stampRotorHash stores the fingerprint of the rotor set in a new key, so loadRotors can check it later
+ * \details Keys naming rotors missing in rotDirectory keep the fingerprint 0 and aren't checked.
+ * \param key newly generated key
+ * \param rotDirectory directory with the rotors of the key
+ */
+void stampRotorHash(TuringaKey& key, const char* rotDirectory);
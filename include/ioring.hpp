@@ -0,0 +1,130 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file ioring.hpp */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "types.hpp"
+
+/*!
+ * class IoRing
+ * \brief minimal io_uring submission and completion queue using the raw system calls
+ * \details Reads and writes are queued by prepare and handed to the kernel by submit, which may also wait for
+ * completions. Completions are collected by pop. Buffers can be registered once, so the kernel doesn't need to map
+ * them for every request. If the kernel lacks io_uring or it is blocked, valid() returns false and the caller has to
+ * fall back to blocking I/O.
+ */
+class IoRing {
+private:
+  int p_descriptor;        /**< file descriptor of the ring, -1 if unavailable */
+  int p_error;             /**< errno of the failed setup */
+  bool p_fixed;            /**< whether buffers have been registered */
+  void* p_sqRing;          /**< mapping of the submission queue ring */
+  void* p_cqRing;          /**< mapping of the completion queue ring, may be the same as p_sqRing */
+  void* p_sqes;            /**< mapping of the submission queue entries */
+  size_t p_sqRingSize;     /**< size of the submission queue ring mapping */
+  size_t p_cqRingSize;     /**< size of the completion queue ring mapping */
+  size_t p_sqesSize;       /**< size of the submission queue entries mapping */
+  unsigned* p_sqTail;      /**< tail of the submission queue, written by us */
+  unsigned* p_sqMask;      /**< mask of the submission queue indices */
+  unsigned* p_sqArray;     /**< indices of the submitted entries */
+  unsigned* p_cqHead;      /**< head of the completion queue, written by us */
+  unsigned* p_cqTail;      /**< tail of the completion queue, written by the kernel */
+  unsigned* p_cqMask;      /**< mask of the completion queue indices */
+  void* p_cqes;            /**< completion queue entries */
+  unsigned p_localTail;    /**< tail including prepared but not submitted entries */
+  unsigned p_unsubmitted;  /**< number of prepared but not submitted entries */
+  unsigned p_inFlight;     /**< number of submitted requests whose completion hasn't been popped */
+
+  void release() noexcept;
+
+public:
+  /*!
+   * \brief IoRing sets up a ring
+   * \param entries number of requests which may be in flight at the same time
+   */
+  explicit IoRing(const unsigned entries);
+
+  IoRing(const IoRing&)            = delete;
+  IoRing& operator=(const IoRing&) = delete;
+
+  /*!
+   * \brief valid tells whether the ring has been set up
+   * \return false if io_uring is not available
+   */
+  bool valid() const noexcept { return p_descriptor >= 0; }
+
+  /*!
+   * \brief error returns the reason why the ring is not valid
+   * \return errno of the failed setup
+   */
+  int error() const noexcept { return p_error; }
+
+  /*!
+   * \brief registerBuffers registers buffers for fixed reads and writes
+   * \details Fails if the locked memory limit is too small, then prepare uses plain reads and writes.
+   * \param buffers start of each buffer
+   * \param count number of buffers
+   * \param size size of each buffer
+   * \return true if the buffers are registered
+   */
+  bool registerBuffers(Byte* const* buffers, const unsigned count, const size_t size);
+
+  /*!
+   * \brief prepare queues a read or write
+   * \param write false reads from the file, true writes to it
+   * \param descriptor file descriptor
+   * \param bytes memory inside buffer number index
+   * \param length number of bytes
+   * \param offset position in the file
+   * \param index number of the registered buffer containing bytes
+   * \param userData returned by pop with the result of this request
+   */
+  void prepare(
+    const bool write, const int descriptor, Byte* bytes, const unsigned length, const uint64_t offset,
+    const unsigned index, const uint64_t userData);
+
+  /*!
+   * \brief submit passes the prepared requests to the kernel
+   * \details Repeats io_uring_enter until the kernel has consumed all prepared requests.
+   * \param wait number of completions to wait for
+   */
+  void submit(const unsigned wait);
+
+  /*!
+   * \brief pop takes the next completion
+   * \param userData set to the userData of the completed request
+   * \param result set to the number of bytes transferred or a negative errno
+   * \return false if there is no completion
+   */
+  bool pop(uint64_t& userData, int& result);
+
+  /*!
+   * \brief drain waits for all submitted requests and drops their completions
+   * \details Afterwards the kernel doesn't access the buffers anymore, so they may be released.
+   */
+  void drain() noexcept;
+
+  /*!
+   * \brief ~IoRing drains the ring, unmaps and closes it
+   */
+  ~IoRing();
+};
@@ -0,0 +1,108 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file kernels.hpp */
+
+#include <cstdint>
+#include <string>
+
+#include "types.hpp"
+
+/** \def KERNEL_X86 the SIMD kernels are compiled for x86 processors and selected at runtime */
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_X86
+#endif
+
+/** \def TARGET_SSE4 compiles a function for processors supporting SSE up to 4.1 */
+#define TARGET_SSE4 __attribute__((target("sse4.1")))
+/** \def TARGET_AVX2 compiles a function for processors supporting AVX2 */
+#define TARGET_AVX2 __attribute__((target("avx2")))
+/** \def TARGET_AVX512 compiles a function for processors supporting AVX-512 with byte and VBMI instructions */
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx512vbmi")))
+
+/** \def AVX512_WARNINGS_OFF starts AVX-512 code, gcc 12 reports the undefined upper lanes inside the AVX-512
+ * intrinsics as uninitialized */
+#define AVX512_WARNINGS_OFF                                                                                         \
+  _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wuninitialized\"")                            \
+    _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+/** \def AVX512_WARNINGS_ON ends the code started by AVX512_WARNINGS_OFF */
+#define AVX512_WARNINGS_ON _Pragma("GCC diagnostic pop")
+
+/*!
+ * \brief enum Kernel specifies the instruction set used by the performance critical functions
+ * \details All kernels are compiled into the same binary, the one in use is chosen once at startup.
+ */
+enum Kernel { generic = 0, sse4 = 1, avx2 = 2, avx512 = 3 };
+
+using RotateFunction = void (*)(Byte*); /**< signature of the implementations of rotate */
+/** signature of the implementations of substitute */
+using SubstituteFunction = void (*)(Byte*, const size_t, const TuringaKey&, const Byte*);
+using RotateNFunction = void (*)(Byte*, const size_t); /**< signature of the implementations of rotate_n */
+/** signature of the implementations of advance and advanceUntil */
+using AdvanceFunction = size_t (*)(Byte*, const size_t, const Byte*);
+/** signature of the implementations of schedule */
+using ScheduleFunction = void (*)(Byte*, const size_t, Byte*);
+/** signature of the implementations of substituteScheduled */
+using ScheduledFunction = void (*)(Byte*, const size_t, const TuringaKey&, const Byte*, const Byte*);
+/** signature of the implementations of the ChaCha block function */
+using ChaChaFunction = void (*)(const uint32_t*, const size_t, Byte*);
+
+/*!
+ * \struct KernelTable
+ * \brief The struct KernelTable holds the implementations of the selected kernel.
+ */
+struct KernelTable {
+  Kernel kernel;                 /**< the selected kernel */
+  RotateFunction rotate;         /**< implementation of rotate */
+  SubstituteFunction substitute; /**< implementation of substitute */
+  RotateNFunction rotate_n;      /**< implementation of rotate_n */
+  AdvanceFunction advance;       /**< implementation of advance and advanceUntil */
+  ScheduleFunction schedule;     /**< implementation of schedule */
+  ScheduledFunction scheduled;   /**< implementation of substituteScheduled */
+  ChaChaFunction chacha;         /**< implementation of the ChaCha block function */
+};
+
+extern KernelTable KERNELS; /**< global variable which holds the kernel in use, initialized with the best one */
+
+/*!
+ * \brief detects the best kernel supported by the processor
+ * \return the kernel using the largest supported instruction set
+ */
+Kernel bestKernel() noexcept;
+
+/*!
+ * \brief tests if the processor supports the instructions used by a kernel
+ * \param kernel the kernel to be tested
+ * \return true if the kernel can be used, otherwise false
+ */
+bool kernelSupported(const Kernel kernel) noexcept;
+
+/*!
+ * \brief returns the name of a kernel as used by the --kernel option
+ * \param kernel the kernel of interest
+ * \return the name of the kernel
+ */
+std::string kernelName(const Kernel kernel) noexcept;
+
+/*!
+ * \brief selectKernel fills the global KernelTable
+ * \details Throws InvalidArgument if the name is unknown or the processor doesn't support the kernel.
+ * \param name either auto for the best supported kernel or the name of a kernel
+ */
+void selectKernel(const std::string& name);
@@ -0,0 +1,73 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file mappedfile.hpp */
+
+#include <cstddef>
+#include <string>
+
+#include "types.hpp"
+
+/*!
+ * \brief enum MapMode specifies how a file is mapped into memory
+ */
+enum MapMode { readOnly = 0, readWrite = 1, create = 2 };
+
+/*!
+ * class MappedFile
+ * \brief file mapped into the address space, so the data is accessed in the page cache without copies
+ * \details Writable mappings are shared, changes end up in the file. Only available on POSIX systems.
+ */
+class MappedFile {
+private:
+  int p_descriptor;       /**< descriptor of the open file */
+  Byte* p_bytes;          /**< start of the mapping, nullptr for empty files */
+  size_t p_size;          /**< size of the mapping in bytes */
+  std::string p_filename; /**< name of the file for error messages */
+
+public:
+  /*!
+   * \brief MappedFile opens and maps a file
+   * \param filename name of the file
+   * \param mode readOnly and readWrite map an existing file, create creates or truncates the file and preallocates
+   * size bytes on disk
+   * \param size size of the file to create, ignored for the other modes
+   */
+  MappedFile(const char* filename, const MapMode mode, const size_t size = 0);
+
+  MappedFile(const MappedFile&)            = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /*!
+   * \brief bytes returns the start of the mapping
+   * \return pointer to the first byte of the file
+   */
+  Byte* bytes() const noexcept { return p_bytes; }
+
+  /*!
+   * \brief size returns the size of the mapping
+   * \return number of bytes of the file
+   */
+  size_t size() const noexcept { return p_size; }
+
+  /*!
+   * \brief ~MappedFile writes back changes, unmaps and closes the file
+   */
+  ~MappedFile();
+};
@@ -0,0 +1,68 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file options.hpp */
+
+#include <cstddef>
+#include <string>
+
+#include "constants.hpp"
+#include "types.hpp"
+
+/*!
+ * \struct CryptOptions
+ * \brief The struct CryptOptions collects the optional settings given as --name=value arguments.
+ */
+struct CryptOptions {
+  size_t checkpointInterval = 0;               /**< distance between two cached rotor states, 0 disables the cache */
+  size_t cacheSize          = STD_CACHE_SIZE;  /**< maximal size of all files in the cache directory in bytes */
+  std::string cacheDir      = STD_CACHE_DIR;   /**< directory where the checkpoint files are stored */
+  Format format             = legacy;          /**< format of files written by encryption */
+  size_t chunkSize          = STD_CHUNK_SIZE;  /**< size of the chunks in the chunked format */
+  std::string kernel        = "auto";          /**< name of the kernel to use, auto selects the best supported */
+  Mode mode                 = interleaved;     /**< whether rotor stepping runs in separate threads */
+  size_t ringDepth          = STD_RING_DEPTH;  /**< number of blocks buffered between stepping and substitution */
+  size_t blockSize          = STD_BLOCK_SIZE;  /**< number of positions per block in the pipelined mode */
+  size_t minCycle           = 0;               /**< genKey rejects keys whose rotor states repeat earlier */
+  size_t threads            = 0;               /**< number of threads, 0 uses all available processors */
+  Placement placement       = heap;            /**< where the data is placed in memory */
+  size_t memory             = 0;               /**< memory cap of the streaming mode, 0 reads the whole file */
+  IOBackend io              = stdio;           /**< how files are read and written */
+  bool inPlace              = false;           /**< transform the input file within its own mapping */
+  bool direct               = false;           /**< read and write with O_DIRECT bypassing the page cache */
+  bool distinctRotors       = false;           /**< genRot derives every rotor from its own ChaCha stream */
+};
+
+/*!
+ * \brief extractOptions removes all arguments starting with -- from argv and parses them
+ * \details The remaining arguments are moved to the front of argv and argc is reduced accordingly. So the positional
+ * arguments can be processed as if no options were given.
+ * \param argc number of arguments, will be reduced by the number of options found
+ * \param argv arguments passed to the program
+ * \return struct of type CryptOptions containing the parsed settings
+ */
+CryptOptions extractOptions(int& argc, char** argv);
+
+/*!
+ * \brief parseSize converts a string like 4096, 64K, 16M or 2G into a number of bytes
+ * \param value string to be converted
+ * \param option name of the option the value belongs to, used for the error message
+ * \return the number of bytes
+ */
+size_t parseSize(const std::string& value, const std::string& option);
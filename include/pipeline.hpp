@@ -0,0 +1,93 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file pipeline.hpp */
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "types.hpp"
+
+/*!
+ * class ScheduleRing
+ * \brief ring buffer passing blocks of rotor states from one stepping thread to one substitution thread
+ * \details Each slot holds the rotor states of blockSize consecutive positions. Only the producer moves the head and
+ * only the consumer moves the tail. A side finding the ring full or empty sleeps on a condition variable until the
+ * other side has moved on.
+ */
+class ScheduleRing {
+private:
+  const size_t p_depth;               /**< number of slots */
+  const size_t p_blockSize;           /**< number of rotor states per slot */
+  std::vector<Byte> p_slots;          /**< memory of all slots */
+  std::mutex p_mutex;                 /**< protects head and tail */
+  std::condition_variable p_changed;  /**< wakes the waiting side when head or tail moved */
+  size_t p_head;                      /**< number of blocks published by the producer */
+  size_t p_tail;                      /**< number of blocks released by the consumer */
+
+public:
+  /*!
+   * \brief ScheduleRing allocates the slots
+   * \param depth number of slots
+   * \param blockSize number of rotor states per slot
+   */
+  ScheduleRing(const size_t depth, const size_t blockSize);
+
+  /*!
+   * \brief reserve waits for a free slot, only called by the producer
+   * \return slot to write the next block of rotor states to
+   */
+  Byte* reserve() noexcept;
+
+  /*!
+   * \brief publish hands the reserved slot over to the consumer
+   */
+  void publish() noexcept;
+
+  /*!
+   * \brief front waits for a published block, only called by the consumer
+   * \return slot containing the next block of rotor states
+   */
+  const Byte* front() noexcept;
+
+  /*!
+   * \brief release returns the slot of the front block to the producer
+   */
+  void release() noexcept;
+
+  ~ScheduleRing() = default;
+};
+
+/*!
+ * \brief substitutePipelined encrypts or decrypts a contiguous range of bytes with a separate stepping thread
+ * \details The stepping thread writes the rotor states into a ScheduleRing, while the calling thread substitutes
+ * the bytes block by block using the states. So the latency bound rotate chain runs beside the lookups. Every
+ * calling thread starts its stepping thread on the first call and keeps it until it exits.
+ * \param bytes first byte to be encrypted/ decrypted
+ * \param length number of bytes
+ * \param key key used for encryption/ decryption, its rotorShifts are advanced by length rotations
+ * \param rotors stores the rotors (byte permutations) used
+ * \param depth number of blocks in the ring buffer
+ * \param blockSize number of positions per block
+ */
+void substitutePipelined(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors, const size_t depth,
+  const size_t blockSize);
@@ -0,0 +1,83 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file positionalfile.hpp */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "types.hpp"
+
+/*!
+ * class PositionalFile
+ * \brief file accessed by reads and writes at explicit offsets
+ * \details Unlike FILE* there is no shared file position, so several threads may read or write different ranges of
+ * the same file at the same time. POSIX systems use pread and pwrite, Windows emulates them under a lock.
+ */
+class PositionalFile {
+private:
+  int p_descriptor;       /**< descriptor of the open file */
+  std::string p_filename; /**< name of the file for error messages */
+
+public:
+  /*!
+   * \brief PositionalFile opens a file
+   * \param filename name of the file
+   * \param write false opens an existing file for reading, true creates or truncates the file for writing
+   */
+  PositionalFile(const char* filename, const bool write);
+
+  PositionalFile(const PositionalFile&)            = delete;
+  PositionalFile& operator=(const PositionalFile&) = delete;
+
+  /*!
+   * \brief descriptor returns the file descriptor, e.g. for asynchronous requests
+   * \return descriptor of the open file
+   */
+  int descriptor() const noexcept { return p_descriptor; }
+
+  /*!
+   * \brief read reads exactly length bytes starting at offset
+   * \param bytes destination
+   * \param length number of bytes
+   * \param offset position in the file
+   */
+  void read(Byte* bytes, const size_t length, const uint64_t offset) const;
+
+  /*!
+   * \brief write writes exactly length bytes starting at offset
+   * \param bytes source
+   * \param length number of bytes
+   * \param offset position in the file
+   */
+  void write(const Byte* bytes, const size_t length, const uint64_t offset) const;
+
+  /*!
+   * \brief reserve sets the size of the file and allocates its blocks up front
+   * \details File systems without fallocate get a sparse file of the right size.
+   * \param size size of the file in bytes
+   */
+  void reserve(const uint64_t size) const;
+
+  /*!
+   * \brief ~PositionalFile closes the file
+   */
+  ~PositionalFile();
+};
@@ -0,0 +1,42 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file processors.hpp */
+
+#include <cstddef>
+#include <string>
+
+/*!
+ * \struct ProcessorBudget
+ * \brief The struct ProcessorBudget holds the number of processors the process may actually use.
+ */
+struct ProcessorBudget {
+  size_t count;       /**< number of processors available, at least 1 */
+  size_t installed;   /**< number of logical processors reported by std::thread::hardware_concurrency */
+  std::string source; /**< what limits the count, e.g. the affinity mask or a cgroup quota */
+};
+
+/*!
+ * \brief availableProcessors determines the processors available to the process on the first call
+ * \details On Linux the count is limited by the affinity mask and by the cpu quota of cgroup v2 (cpu.max) or cgroup
+ * v1 (cpu.cfs_quota_us), so containers don't start more threads than they get processor time for. Fractional quotas
+ * are rounded up.
+ * \return reference to the result
+ */
+const ProcessorBudget& availableProcessors();
@@ -19,6 +19,7 @@
 
 /*! \file rotate.hpp */
 
+#include "kernels.hpp"
 #include "types.hpp"
 
 /*!
@@ -41,6 +42,71 @@
  * \authors Max, Jurek
  * \param fileShifts determines the current substitution
  * \details This function replaces the rotation of wheels in enigma. This part is most critical for
- * security.
+ * security. The implementation of the kernel selected at startup is used.
  */
 void rotate(Byte* rotorShifts);
+
+/*!
+ * \brief rotate_n applies rotate once to each of count independent rotor states
+ * \details The states are stored one after another, each MAX_KEYLENGTH bytes long. The vector kernels step several
+ * states per instruction and interleave their dependency chains, so the throughput is much higher than calling rotate
+ * for each state.
+ * \param states count * MAX_KEYLENGTH bytes
+ * \param count number of states
+ */
+void rotate_n(Byte* states, const size_t count);
+
+/*!
+ * \brief advance applies rotate steps times
+ * \details The state is loaded once and stays in registers for all steps.
+ * \param rotorShifts current rotor state, it's advanced by steps rotations
+ * \param steps number of rotations
+ */
+void advance(Byte* rotorShifts, const size_t steps);
+
+/*!
+ * \brief advanceUntil applies rotate at most steps times and stops as soon as the state equals target
+ * \param rotorShifts current rotor state, it's advanced by the returned number of rotations
+ * \param steps maximal number of rotations
+ * \param target rotor state to be searched for
+ * \return number of rotations applied, if it's less than steps the target has been reached
+ */
+size_t advanceUntil(Byte* rotorShifts, const size_t steps, const Byte* target);
+
+/*!
+ * \brief schedule writes the rotor states of count consecutive positions
+ * \details The states are stored one after another, each of them MAX_KEYLENGTH bytes long. The first one is the
+ * given state. The SIMD kernels keep the state in a register while stepping.
+ * \param states count * MAX_KEYLENGTH bytes where the states are written to
+ * \param count number of states
+ * \param rotorShifts current rotor state, it's advanced by count rotations
+ */
+void schedule(Byte* states, const size_t count, Byte* rotorShifts);
+
+/*!
+ * \brief rotateVariant returns the implementation of rotate using the instructions of the given kernel
+ * \param kernel specifies the instruction set
+ * \return pointer to the implementation
+ */
+RotateFunction rotateVariant(const Kernel kernel);
+
+/*!
+ * \brief rotateNVariant returns the implementation of rotate_n using the instructions of the given kernel
+ * \param kernel specifies the instruction set
+ * \return pointer to the implementation
+ */
+RotateNFunction rotateNVariant(const Kernel kernel);
+
+/*!
+ * \brief advanceVariant returns the implementation of advance using the instructions of the given kernel
+ * \param kernel specifies the instruction set
+ * \return pointer to the implementation
+ */
+AdvanceFunction advanceVariant(const Kernel kernel);
+
+/*!
+ * \brief scheduleVariant returns the implementation of schedule using the instructions of the given kernel
+ * \param kernel specifies the instruction set
+ * \return pointer to the implementation
+ */
+ScheduleFunction scheduleVariant(const Kernel kernel);
@@ -0,0 +1,437 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2021  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file rotatekernels.hpp
+ * The implementations of rotate for each kernel. They are defined inline, so the kernels in other translation units
+ * can inline them into their loops. Each function is compiled for its own instruction set using target attributes.
+ */
+
+#include "constants.hpp"
+#include "kernels.hpp"
+#include "types.hpp"
+
+#if defined(KERNEL_X86)
+#include <immintrin.h>
+#endif
+
+/***************************************************************************************************
+ *                                 standard version
+ **************************************************************************************************/
+static inline void rotate_generic(Byte* rotorShifts) {
+  // table for inverting polynomial  in GF(2) of degree <= 3 mod x^4 + x +1
+  Byte table[16];
+  table[0]    = 0b0000;
+  table[1]    = 0b0001;
+  table[2]    = 0b1001;
+  table[3]    = 0b1110;
+  table[4]    = 0b1101;
+  table[5]    = 0b1011;
+  table[6]    = 0b0111;
+  table[7]    = 0b0110;
+  table[8]    = 0b1111;
+  table[9]    = 0b0010;
+  table[10]   = 0b1100;
+  table[11]   = 0b0101;
+  table[12]   = 0b1010;
+  table[13]   = 0b0100;
+  table[14]   = 0b0011;
+  table[15]   = 0b1000;
+
+  Byte x[MAX_KEYLENGTH * 2];
+  for (size_t i = 0; i < MAX_KEYLENGTH; i++) {
+    x[2 * i]     = rotorShifts[i] & 0b00001111;  // the rightmost bits
+    x[2 * i + 1] = rotorShifts[i] >> 4;          // the leftmost bits
+  }
+
+  ++rotorShifts[0];
+  Byte mode = table[x[0]] & x[2 * MAX_KEYLENGTH - 1];
+  mode      = !(__builtin_popcount(mode) & 0b00000001);
+
+  for (size_t i = 1; i < MAX_KEYLENGTH; i++) {
+    Byte val = table[x[i]];
+    val &= x[2 * MAX_KEYLENGTH - 1 - i];                                              // bitwise xor
+    rotorShifts[i] += (2 * i + 1) * ((mode ^ __builtin_popcount(val)) & 0b00000001);  // test val is uneven
+  }
+}
+
+#if defined(KERNEL_X86)
+/***************************************************************************************************
+ *                                      SSE version
+ **************************************************************************************************/
+TARGET_SSE4 static inline void rotate_sse4(Byte* rotorShifts) {
+// disable gcc warning -Woverflow
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverflow"
+  const __m128i low_4_bits_mask  = _mm_set1_epi8(0b00001111);
+  const __m128i high_4_bits_mask = _mm_set1_epi8(0b11110000);
+
+  // table for inverting polynomial  in GF(2) of degree <= 3 mod x^4 + x +1
+  const __m128i reverseOrder = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  const __m128i table        = _mm_setr_epi8(
+    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
+    0b0011, 0b1000);
+  const __m128i lookup_sum = _mm_setr_epi8(
+    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
+    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000);
+  const __m128i rotor_intervals_1 = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+  const __m128i rotor_intervals_2 = _mm_setr_epi8(33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63);
+  const __m128i shuffle_high      = _mm_setr_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+// enable gcc warning -Woverflow
+#pragma GCC diagnostic pop
+
+  // load bytes from rotorShifts
+  __m128i values1 = _mm_loadu_si128((__m128i*) rotorShifts);
+  __m128i values2 = _mm_loadu_si128((__m128i*) rotorShifts + 1);
+
+  // prepair the vectors for scalar products
+  __m128i x1, x2, x3, x4, y1, y2, y3, y4;
+  // first stretch the bytes to the size of two bytes
+  x1 = _mm_cvtepu8_epi16(values1);
+  x3 = _mm_shuffle_epi8(values1, shuffle_high);
+  x3 = _mm_cvtepu8_epi16(x3);
+
+  // split vectors into 4 lower and 4 higher bits
+  x2 = _mm_and_si128(x1, high_4_bits_mask);
+  x1 = _mm_and_si128(x1, low_4_bits_mask);
+  x4 = _mm_and_si128(x3, high_4_bits_mask);
+  x3 = _mm_and_si128(x3, low_4_bits_mask);
+
+  // shift from higher 4 bits to lower 4 bits of next byte
+  x2 = _mm_slli_epi32(x2, 4);
+  x4 = _mm_slli_epi32(x4, 4);
+
+  // assemble the x vectors
+  x1 = _mm_add_epi8(x1, x2);
+  x2 = _mm_add_epi8(x3, x4);
+
+  // first stretch the bytes to the size of two bytes
+  y1 = _mm_cvtepu8_epi16(values2);
+  y3 = _mm_shuffle_epi8(values2, shuffle_high);
+  y3 = _mm_cvtepu8_epi16(y3);
+
+  // split vectors into 4 lower and 4 higher bits
+  y2 = _mm_and_si128(y1, high_4_bits_mask);
+  y1 = _mm_and_si128(y1, low_4_bits_mask);
+  y4 = _mm_and_si128(y3, high_4_bits_mask);
+  y3 = _mm_and_si128(y3, low_4_bits_mask);
+
+  // shift from higher 4 bits to lower 4 bits of next byte
+  y2 = _mm_slli_epi32(y2, 4);
+  y4 = _mm_slli_epi32(y4, 4);
+
+  // assemble the y vectors
+  y1 = _mm_add_epi8(y1, y2);
+  y2 = _mm_add_epi8(y3, y4);
+
+  // function pi(y)
+  x1 = _mm_shuffle_epi8(table, x1);  // maps x1[i] := table[x1[i]]
+  x2 = _mm_shuffle_epi8(table, x2);  // maps x2[i] := table[x2[i]]
+
+  // revert the order of the y
+  y1 = _mm_shuffle_epi8(y1, reverseOrder);
+  y2 = _mm_shuffle_epi8(y2, reverseOrder);
+
+  // the "inner product" of x and y
+  __m128i z1 = _mm_and_si128(x1, y2);
+  __m128i z2 = _mm_and_si128(x2, y1);
+  z1         = _mm_shuffle_epi8(lookup_sum, z1);
+  z2         = _mm_shuffle_epi8(lookup_sum, z2);
+
+  // if the first entry is 0 invert enverything
+  __m128i mode = _mm_set1_epi8(_mm_extract_epi8(z1, 0));
+  z1           = _mm_cmpeq_epi8(z1, mode);
+  z2           = _mm_cmpeq_epi8(z2, mode);
+
+  // multyply the indicatorvariable z with the shifts
+  z1 = _mm_and_si128(z1, rotor_intervals_1);
+  z2 = _mm_and_si128(z2, rotor_intervals_2);
+
+  // add rotorshift to rotors
+  values1 = _mm_add_epi8(values1, z1);
+  values2 = _mm_add_epi8(values2, z2);
+
+  // save the maipulated rotorshifts
+  _mm_storeu_si128((__m128i*) rotorShifts, values1);
+  _mm_storeu_si128((__m128i*) rotorShifts + 1, values2);
+}
+
+/*!
+ * \brief step_sse4 computes the next rotor state while the state stays in two registers
+ * \details The parity of nibble 2k is computed with the high nibble of byte 31 - k and the parity of nibble 2k + 1
+ * with the low nibble of byte 31 - k. So only the last 16 bytes have to be reversed and the chain of dependent
+ * instructions never leaves the vector unit, which makes this version the fastest to iterate.
+ * \param first the first 16 bytes of the rotor state
+ * \param last the last 16 bytes of the rotor state
+ */
+TARGET_SSE4 static inline void step_sse4(__m128i& first, __m128i& last) {
+// disable gcc warning -Woverflow
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverflow"
+  const __m128i low     = _mm_set1_epi8(0b00001111);  // low bit mask
+  const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  const __m128i table   = _mm_setr_epi8(
+    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
+    0b0011, 0b1000);  // lookup table for inverting
+  const __m128i lookup_sum = _mm_setr_epi8(
+    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
+    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000);
+  const __m128i rotor_intervals_1 = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+  const __m128i rotor_intervals_2 = _mm_setr_epi8(33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63);
+// enable gcc warning -Woverflow
+#pragma GCC diagnostic pop
+
+  // split the first bytes and the reversed last bytes into nibbles
+  const __m128i reversed = _mm_shuffle_epi8(last, reverse);
+  const __m128i xLow     = _mm_and_si128(first, low);
+  const __m128i xHigh    = _mm_and_si128(_mm_srli_epi16(first, 4), low);
+  const __m128i yLow     = _mm_and_si128(reversed, low);
+  const __m128i yHigh    = _mm_and_si128(_mm_srli_epi16(reversed, 4), low);
+
+  // parities of the "inner products" for the even and the odd nibbles
+  const __m128i even = _mm_shuffle_epi8(lookup_sum, _mm_and_si128(_mm_shuffle_epi8(table, xLow), yHigh));
+  const __m128i odd  = _mm_shuffle_epi8(lookup_sum, _mm_and_si128(_mm_shuffle_epi8(table, xHigh), yLow));
+
+  // rotors with the same parity as the first one are shifted
+  const __m128i mode = _mm_shuffle_epi8(even, _mm_setzero_si128());
+  const __m128i z1   = _mm_cmpeq_epi8(_mm_unpacklo_epi8(even, odd), mode);
+  const __m128i z2   = _mm_cmpeq_epi8(_mm_unpackhi_epi8(even, odd), mode);
+  first              = _mm_add_epi8(first, _mm_and_si128(z1, rotor_intervals_1));
+  last               = _mm_add_epi8(last, _mm_and_si128(z2, rotor_intervals_2));
+}
+
+/***************************************************************************************************
+ *                                      AVX2 version
+ **************************************************************************************************/
+/*!
+ * \brief step_avx2 computes the next rotor state while the state stays in a register
+ * \param state current rotor state
+ * \return the rotor state after one rotation
+ */
+TARGET_AVX2 static inline __m256i step_avx2(const __m256i state) {
+// disable gcc warning -Woverflow
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverflow"
+  const __m256i low     = _mm256_set1_epi8(0b00001111);  // low bit mask
+  const __m256i reverse = _mm256_setr_epi8(
+    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  const __m256i table = _mm256_setr_epi8(
+    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
+    0b0011, 0b1000, 0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101,
+    0b1010, 0b0100, 0b0011, 0b1000);  // lookup table for inverting
+  const __m256i lookup_sum = _mm256_setr_epi8(
+    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
+    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b00000000, 0b11111111,
+    0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b00000000,
+    0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000);
+  const __m256i rotor_intervals = _mm256_setr_epi8(
+    1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31, 33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59,
+    61, 63);  // lookup table: i-th entry is 2*i +1
+// enable gcc warning -Woverflow
+#pragma GCC diagnostic pop
+
+  __m128i a = _mm256_castsi256_si128(state);       // the first 16 byte
+  __m128i b = _mm256_extracti128_si256(state, 1);  // the last 16 byte
+
+  // spread each byte into 2 (only in the lower 8 bit)
+  __m256i x = _mm256_cvtepu8_epi16(a);
+  __m256i y = _mm256_cvtepu8_epi16(b);
+
+  // shift 4 bits to the left
+  __m256i x2 = _mm256_slli_epi16(x, 4);
+  __m256i y2 = _mm256_slli_epi16(y, 4);
+
+  __m256i x1, y1;
+
+  // take only the lower 4 bits of each byte
+  x1 = _mm256_and_si256(x, low);
+  x2 = _mm256_and_si256(x2, low);
+  y1 = _mm256_and_si256(y, low);
+  y2 = _mm256_and_si256(y2, low);
+
+  // obtain x and y by adding
+  x = _mm256_or_si256(x1, x2);
+  y = _mm256_or_si256(y1, y2);
+
+  // invert using the lookup table x[i] := table[x[i]]
+  x = _mm256_shuffle_epi8(table, x);
+
+  // invert the order of y
+  y = _mm256_permute2x128_si256(y, y, 0b00000001);  // swaps the first and the last 128 bits
+  y = _mm256_shuffle_epi8(y, reverse);
+
+  // take the "inner product" of x and y
+  __m256i z = _mm256_and_si256(x, y);              // elementwise and
+  z         = _mm256_shuffle_epi8(lookup_sum, z);  // sum over all elements using the lookup sum
+
+  // if the first entry is 0 invert enverything
+  __m256i mode = _mm256_set1_epi8(_mm256_extract_epi8(z, 0));
+  z            = _mm256_cmpeq_epi8(z, mode);
+
+  // set each position of z to 0 or rotor intervals and add to values
+  z              = _mm256_and_si256(z, rotor_intervals);
+  return _mm256_add_epi8(state, z);  // add z to the values
+}
+
+TARGET_AVX2 static inline void rotate_avx2(Byte* rotorShifts) {
+  const __m256i state = _mm256_loadu_si256((__m256i*) rotorShifts);
+  _mm256_storeu_si256((__m256i*) rotorShifts, step_avx2(state));
+}
+
+/*!
+ * \brief step_x2_avx2 computes the next rotor state of two independent states at once
+ * \details Does the same as step_sse4 in each 128 bit lane, so lane i holds the halves of state i.
+ * \param first the first 16 bytes of both rotor states
+ * \param last the last 16 bytes of both rotor states
+ */
+TARGET_AVX2 static inline void step_x2_avx2(__m256i& first, __m256i& last) {
+// disable gcc warning -Woverflow
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverflow"
+  const __m256i low     = _mm256_set1_epi8(0b00001111);  // low bit mask
+  const __m256i reverse = _mm256_broadcastsi128_si256(
+    _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+  const __m256i table = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
+    0b0011, 0b1000));  // lookup table for inverting
+  const __m256i lookup_sum = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
+    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000));
+  const __m256i rotor_intervals_1 = _mm256_broadcastsi128_si256(
+    _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31));
+  const __m256i rotor_intervals_2 = _mm256_broadcastsi128_si256(
+    _mm_setr_epi8(33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63));
+// enable gcc warning -Woverflow
+#pragma GCC diagnostic pop
+
+  const __m256i reversed = _mm256_shuffle_epi8(last, reverse);
+  const __m256i xLow     = _mm256_and_si256(first, low);
+  const __m256i xHigh    = _mm256_and_si256(_mm256_srli_epi16(first, 4), low);
+  const __m256i yLow     = _mm256_and_si256(reversed, low);
+  const __m256i yHigh    = _mm256_and_si256(_mm256_srli_epi16(reversed, 4), low);
+
+  const __m256i even = _mm256_shuffle_epi8(lookup_sum, _mm256_and_si256(_mm256_shuffle_epi8(table, xLow), yHigh));
+  const __m256i odd  = _mm256_shuffle_epi8(lookup_sum, _mm256_and_si256(_mm256_shuffle_epi8(table, xHigh), yLow));
+
+  const __m256i mode = _mm256_shuffle_epi8(even, _mm256_setzero_si256());
+  const __m256i z1   = _mm256_cmpeq_epi8(_mm256_unpacklo_epi8(even, odd), mode);
+  const __m256i z2   = _mm256_cmpeq_epi8(_mm256_unpackhi_epi8(even, odd), mode);
+  first              = _mm256_add_epi8(first, _mm256_and_si256(z1, rotor_intervals_1));
+  last               = _mm256_add_epi8(last, _mm256_and_si256(z2, rotor_intervals_2));
+}
+/***************************************************************************************************
+ *                                     AVX-512 version
+ **************************************************************************************************/
+AVX512_WARNINGS_OFF
+/*!
+ * \brief step_avx512 computes the next rotor state while the state stays in a register
+ * \details Uses vpermb from AVX-512 VBMI to split the state into nibbles and to reverse their order.
+ * \param state current rotor state
+ * \return the rotor state after one rotation
+ */
+TARGET_AVX512 static inline __m256i step_avx512(const __m256i state) {
+// disable gcc warning -Woverflow
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverflow"
+  const __m512i low    = _mm512_set1_epi8(0b00001111);  // low bit mask
+  const __m512i spread = _mm512_set_epi8(
+    31, 31, 30, 30, 29, 29, 28, 28, 27, 27, 26, 26, 25, 25, 24, 24, 23, 23, 22, 22, 21, 21, 20, 20, 19, 19, 18, 18, 17,
+    17, 16, 16, 15, 15, 14, 14, 13, 13, 12, 12, 11, 11, 10, 10, 9, 9, 8, 8, 7, 7, 6, 6, 5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0,
+    0);  // i-th entry is i / 2
+  const __m512i reverse = _mm512_set_epi8(
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30,
+    31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59,
+    60, 61, 62, 63);  // i-th entry is 63 - i
+  const __m512i table = _mm512_broadcast_i32x4(_mm_setr_epi8(
+    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
+    0b0011, 0b1000));  // lookup table for inverting
+  const __m512i lookup_sum = _mm512_broadcast_i32x4(_mm_setr_epi8(
+    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
+    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000));
+  const __m256i rotor_intervals = _mm256_setr_epi8(
+    1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31, 33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59,
+    61, 63);  // lookup table: i-th entry is 2*i +1
+// enable gcc warning -Woverflow
+#pragma GCC diagnostic pop
+
+  // copy each byte twice, then take the lower 4 bits from even and the higher 4 bits from odd positions
+  __m512i x = _mm512_permutexvar_epi8(spread, _mm512_zextsi256_si512(state));
+  x         = _mm512_mask_blend_epi8(0xAAAAAAAAAAAAAAAA, x, _mm512_srli_epi16(x, 4));
+  x         = _mm512_and_si512(x, low);
+
+  // the i-th nibble is combined with the inverted (63 - i)-th nibble
+  const __m512i y = _mm512_permutexvar_epi8(reverse, x);
+  x               = _mm512_shuffle_epi8(table, x);
+
+  // take the "inner product" of x and y
+  __m512i z = _mm512_and_si512(x, y);
+  z         = _mm512_shuffle_epi8(lookup_sum, z);
+
+  // rotors with the same parity as the first one are shifted
+  const __mmask32 shift = _mm512_cmpeq_epi8_mask(z, _mm512_broadcastb_epi8(_mm512_castsi512_si128(z)));
+  return _mm256_mask_add_epi8(state, shift, state, rotor_intervals);
+}
+
+TARGET_AVX512 static inline void rotate_avx512(Byte* rotorShifts) {
+  const __m256i state = _mm256_loadu_si256((__m256i*) rotorShifts);
+  _mm256_storeu_si256((__m256i*) rotorShifts, step_avx512(state));
+}
+
+/*!
+ * \brief step_x4_avx512 computes the next rotor state of four independent states at once
+ * \details Does the same as step_sse4 in each 128 bit lane, so lane i holds the halves of state i.
+ * \param first the first 16 bytes of the four rotor states
+ * \param last the last 16 bytes of the four rotor states
+ */
+TARGET_AVX512 static inline void step_x4_avx512(__m512i& first, __m512i& last) {
+// disable gcc warning -Woverflow
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverflow"
+  const __m512i low     = _mm512_set1_epi8(0b00001111);  // low bit mask
+  const __m512i reverse = _mm512_broadcast_i32x4(_mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+  const __m512i table   = _mm512_broadcast_i32x4(_mm_setr_epi8(
+    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
+    0b0011, 0b1000));  // lookup table for inverting
+  const __m512i lookup_sum = _mm512_broadcast_i32x4(_mm_setr_epi8(
+    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
+    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000));
+  const __m512i rotor_intervals_1 = _mm512_broadcast_i32x4(
+    _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31));
+  const __m512i rotor_intervals_2 = _mm512_broadcast_i32x4(
+    _mm_setr_epi8(33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63));
+// enable gcc warning -Woverflow
+#pragma GCC diagnostic pop
+
+  const __m512i reversed = _mm512_shuffle_epi8(last, reverse);
+  const __m512i xLow     = _mm512_and_si512(first, low);
+  const __m512i xHigh    = _mm512_and_si512(_mm512_srli_epi16(first, 4), low);
+  const __m512i yLow     = _mm512_and_si512(reversed, low);
+  const __m512i yHigh    = _mm512_and_si512(_mm512_srli_epi16(reversed, 4), low);
+
+  const __m512i even = _mm512_shuffle_epi8(lookup_sum, _mm512_and_si512(_mm512_shuffle_epi8(table, xLow), yHigh));
+  const __m512i odd  = _mm512_shuffle_epi8(lookup_sum, _mm512_and_si512(_mm512_shuffle_epi8(table, xHigh), yLow));
+
+  // the masks select the rotors with the same parity as the first one of their state
+  const __m512i mode = _mm512_shuffle_epi8(even, _mm512_setzero_si512());
+  const __mmask64 z1 = _mm512_cmpeq_epi8_mask(_mm512_unpacklo_epi8(even, odd), mode);
+  const __mmask64 z2 = _mm512_cmpeq_epi8_mask(_mm512_unpackhi_epi8(even, odd), mode);
+  first              = _mm512_mask_add_epi8(first, z1, first, rotor_intervals_1);
+  last               = _mm512_mask_add_epi8(last, z2, last, rotor_intervals_2);
+}
+AVX512_WARNINGS_ON
+#endif
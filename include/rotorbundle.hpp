@@ -0,0 +1,93 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file rotorbundle.hpp */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mappedfile.hpp"
+#include "types.hpp"
+
+/*!
+ * class RotorBundle
+ * \brief all rotors of a directory packed into one file, which is mapped read only
+ * \details The bundle starts with magic bytes, version, number of rotors and number of distinct tables. An index of the
+ * names, table positions and hashes of the rotors follows, then the 256 bytes of each distinct permutation and the 256
+ * bytes of its inverse. All processes mapping the bundle share its pages. The hashes and the inverses are verified
+ * when the bundle is opened.
+ */
+class RotorBundle {
+private:
+  std::unique_ptr<MappedFile> p_mapping; /**< mapping of the bundle, nullptr where mapping isn't supported */
+  std::vector<Byte> p_copy;              /**< contents of the bundle where it can't be mapped */
+  const Byte* p_bytes;                   /**< start of the contents */
+  size_t p_count;                        /**< number of rotors */
+  size_t p_distinct;                     /**< number of distinct tables, identical rotors share one */
+  int p_index[256];                      /**< position of each rotor name in the bundle, -1 for missing rotors */
+  std::string p_filename;                /**< name of the file for error messages */
+
+public:
+  /*!
+   * \brief RotorBundle maps a bundle and verifies it
+   * \param filename name of the bundle
+   */
+  explicit RotorBundle(const std::string& filename);
+
+  RotorBundle(const RotorBundle&)            = delete;
+  RotorBundle& operator=(const RotorBundle&) = delete;
+
+  /*!
+   * \brief names returns the names of all rotors in the bundle
+   * \return one character per rotor
+   */
+  std::string names() const;
+
+  /*!
+   * \brief table returns the permutation of a rotor inside the mapping
+   * \param name name of the rotor
+   * \param direction encryption for the permutation, decryption for its inverse
+   * \return 256 bytes, nullptr if the bundle doesn't contain the rotor
+   */
+  const Byte* table(const char name, const Direction direction) const;
+
+  /*!
+   * \brief distinct returns the number of distinct tables
+   * \return number of tables stored in the bundle
+   */
+  size_t distinct() const noexcept;
+};
+
+/*!
+ * \brief findRotorFiles detects the rotors stored as separate files with a single listing of the directory
+ * \param directory directory to search for rotor_<name> and rotor_<name>_reverse
+ * \return names of the rotors found in the order of VALID_ROT_NAMES
+ */
+std::string findRotorFiles(const std::string& directory);
+
+/*!
+ * \brief writeRotorBundle packs the rotor files of a directory into its bundle
+ * \details The bundle is written to a temporary file first and renamed, so processes using the old bundle keep a
+ * consistent mapping.
+ * \param directory directory containing the rotor files, the bundle is written there as well
+ */
+void writeRotorBundle(const std::string& directory);
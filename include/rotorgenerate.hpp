@@ -19,10 +19,99 @@
 
 /*! \file rotorgenerate.hpp */
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <string>
+
+#include "chacha.hpp"
+#include "options.hpp"
+#include "types.hpp"
+
+/** 256 bytes of a rotor, a permutation of all bytes */
+using RotorTable = std::array<Byte, 256>;
+
+/*!
+ * \brief shuffleRotor shuffles the identity by a Fisher-Yates shuffle
+ * \param words 256 random words, the i-th one picks the byte moved to position 255 - i
+ * \return permutation of the rotor
+ */
+constexpr RotorTable shuffleRotor(const uint32_t* words) {
+  RotorTable table = {};
+  for (size_t i = 0; i < 256; ++i) {
+    table[i] = i;
+  }
+  for (size_t i = 0; i < 256; ++i) {
+    const size_t a   = words[i] % (256 - i);
+    const Byte value = table[a];
+    table[a]         = table[255 - i];
+    table[255 - i]   = value;
+  }
+  return table;
+}
+
+/*!
+ * \brief rotorPermutation shuffles the identity with the first words of the ChaCha blocks of the seed
+ * \details This is the permutation written by generateRotor for all names, it can be computed by the compiler.
+ * \param seed seed of the rotor
+ * \return permutation of the rotor
+ */
+constexpr RotorTable rotorPermutation(const uint64_t seed) {
+  uint32_t expanded[12] = {};
+  expandSeed(expanded, seed);
+  ChaCha rng;
+  rng.init(expanded);
+  uint32_t words[256] = {};
+  for (size_t i = 0; i < 256; ++i) {
+    words[i] = rng.get();
+  }
+  return shuffleRotor(words);
+}
+
+/*!
+ * \brief distinctRotorPermutation shuffles the identity with the whole ChaCha stream of seed and name
+ * \details The seed is the key of ChaCha and the name its nonce, so every name gets its own stream. All 16 words of
+ * a block are used, a rotor takes 16 blocks.
+ * \param seed seed of the rotor set
+ * \param name name of the rotor
+ * \return permutation of the rotor
+ */
+RotorTable distinctRotorPermutation(const uint64_t seed, const char name);
+
+/*!
+ * \brief invertRotor computes the inverse of a permutation
+ * \param permutation permutation of a rotor
+ * \return table of the reverse rotor
+ */
+constexpr RotorTable invertRotor(const RotorTable& permutation) {
+  RotorTable inverse = {};
+  for (size_t i = 0; i < 256; ++i) {
+    inverse[permutation[i]] = i;
+  }
+  return inverse;
+}
 
 /*!
  * \brief generateRotor generates new rotors for the names
+ * \details By default all names get the same permutation of the seed. With options.distinctRotors every name gets
+ * its own one, they are computed and written by the thread pool.
  * \param rotorsNames all chars corresponding to a rotors name
+ * \param givenSeed seed of the rotors
+ * \param options options.distinctRotors selects the derivation, options.threads limits the threads
+ */
+void generateRotor(const char* rotorNames, const uint64_t givenSeed = 0, const CryptOptions& options = CryptOptions());
+
+/*!
+ * \brief embeddedRotorNames returns the names of the rotors compiled into the binary
+ * \return all valid rotor names if the binary was built with EmbedRotors, otherwise an empty string
+ */
+std::string embeddedRotorNames();
+
+/*!
+ * \brief embeddedRotor returns a rotor compiled into the binary
+ * \details The embedded rotors are the ones written by genRot -a with the seed given to CMake.
+ * \param name name of the rotor
+ * \param direction encryption for the permutation, decryption for its inverse
+ * \return 256 bytes in the read only data of the binary, nullptr if the rotor isn't embedded
  */
-void generateRotor(const char* rotorNames, const uint64_t givenSeed = 0);
+const Byte* embeddedRotor(const char name, const Direction direction);
@@ -0,0 +1,75 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file substitute.hpp */
+
+#include <cstddef>
+
+#include "kernels.hpp"
+#include "types.hpp"
+
+/*!
+ * \brief substitute encrypts or decrypts a contiguous range of bytes in place
+ * \details Each byte passes all rotors of the key, afterwards the rotor state is rotated. The SIMD kernels first
+ * materialise the rotor states of a block of positions and then substitute all bytes of the block at once.
+ * \param bytes first byte to be encrypted/ decrypted
+ * \param length number of bytes
+ * \param key key used for encryption/ decryption, its rotorShifts are advanced by length rotations
+ * \param rotors ROTOR_MEMORY bytes, the rotors (byte permutations) used followed by the tables of deriveRotorTables
+ */
+void substitute(Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors);
+
+/*!
+ * \brief substituteScheduled encrypts or decrypts a contiguous range of bytes using precomputed rotor states
+ * \details The rotor states are computed beforehand by schedule, so the substitution doesn't depend on rotate.
+ * \param bytes first byte to be encrypted/ decrypted
+ * \param length number of bytes
+ * \param key key used for encryption/ decryption, only direction and length are used
+ * \param states length * MAX_KEYLENGTH bytes, the rotor state of each byte
+ * \param rotors ROTOR_MEMORY bytes, the rotors (byte permutations) used followed by the tables of deriveRotorTables
+ */
+void substituteScheduled(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* states, const Byte* rotors);
+
+/*!
+ * \brief deriveRotorTables fills the tables the SIMD kernels derive from the rotors
+ * \details The tables follow the 256 * MAX_KEYLENGTH bytes of the rotors in the same buffer, so they are built once
+ * per key instead of once per call of substitute.
+ * \param rotors ROTOR_MEMORY bytes, the first 256 * keylength contain the rotors
+ * \param keylength number of rotors
+ */
+void deriveRotorTables(Byte* rotors, const size_t keylength);
+
+/*!
+ * \brief substituteVariant returns the implementation of substitute using the instructions of the given kernel
+ * \details The scalar kernel is instantiated for each key length and both directions, so the chain of rotors is
+ * unrolled completely. The returned function dispatches to the instantiation matching the key. The SIMD kernels keep
+ * the loop, their rotor chain is bound by the table lookups and unrolling showed no gain.
+ * \param kernel specifies the instruction set
+ * \param specialised if false the version with a loop over the rotors is returned, used for benchmarks
+ * \return pointer to the implementation
+ */
+SubstituteFunction substituteVariant(const Kernel kernel, const bool specialised = true);
+
+/*!
+ * \brief scheduledVariant returns the implementation of substituteScheduled using the instructions of the given kernel
+ * \param kernel specifies the instruction set
+ * \return pointer to the implementation
+ */
+ScheduledFunction scheduledVariant(const Kernel kernel);
@@ -1,4 +1,95 @@
 #pragma once
+
+/*! \file testrotate.hpp */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "types.hpp"
 
-void findCycle(const Byte* rotorShifts, size_t maxIter = 1e12);
+/*!
+ * \struct CycleInfo
+ * \brief The struct CycleInfo describes the sequence of rotor states starting at some state.
+ * \details The states x_0, x_1, ... eventually repeat. The first tail states are visited once, afterwards the states
+ * repeat with a period of length, i.e. x_{i + length} = x_i for all i >= tail.
+ */
+struct CycleInfo {
+  bool found;    /**< true if a repetition was found within the checked iterations */
+  size_t tail;   /**< number of states before the cycle */
+  size_t length; /**< length of the cycle */
+};
+
+/** number of steps between two updates of the progress of a cycle search */
+inline const size_t CYCLE_PROGRESS_STEPS = 1e7;
+
+/*!
+ * \brief brentCycle searches the cycle of any sequence x_{i + 1} = f(x_i) using Brent's algorithm
+ * \details The hare walks up to power steps from the tortoise, then the tortoise jumps to the hare. A repetition with
+ * tail + length <= maxIter is found within less than 2 (tail + length) + length <= 3 maxIter steps, so the search
+ * gets 3 maxIter steps and decides by tail + length afterwards.
+ * \param start initial state x_0
+ * \param maxIter the repetition has to happen within maxIter steps, i.e. tail + length <= maxIter
+ * \param walk size_t(State& hare, size_t steps, const State& target) applies f at most steps times, stops as soon as
+ * the hare equals target and returns the number of steps done
+ * \param findTail size_t(size_t length) returns the tail of the sequence with a cycle of given length
+ * \param progress is increased by the number of steps done, may be read by other threads
+ * \return struct of type CycleInfo, found is false if no state repeats within maxIter steps
+ */
+template <class State, class Walk, class FindTail>
+CycleInfo brentCycle(
+  const State& start, const size_t maxIter, Walk walk, FindTail findTail, std::atomic<size_t>& progress) {
+  const size_t budget = (maxIter > SIZE_MAX / 3) ? SIZE_MAX : 3 * maxIter;
+  State tortoise      = start;
+  State hare          = start;
+  size_t iteration    = 0;
+  for (size_t power = 1; iteration < budget; power *= 2) {
+    tortoise      = hare;
+    size_t length = 0;
+    while (length < power && iteration < budget) {
+      // report the progress regularly
+      const size_t steps = std::min({power - length, CYCLE_PROGRESS_STEPS, budget - iteration});
+      const size_t done  = walk(hare, steps, tortoise);
+      length += done;
+      iteration += done;
+      progress += done;
+      if (hare == tortoise) {
+        const size_t tail = findTail(length);
+        return (tail + length <= maxIter) ? CycleInfo{true, tail, length} : CycleInfo{false, 0, 0};
+      }
+    }
+  }
+  return CycleInfo{false, 0, 0};
+}
+
+/*!
+ * \brief findCycle searches the cycle of the rotor states using Brent's algorithm
+ * \details Needs memory for three states only. If a cycle is found, its exact length and the exact tail are computed.
+ * The search takes up to 3 maxIter rotations, see brentCycle.
+ * \param rotorShifts initial rotor state
+ * \param maxIter a repetition is reported if tail + length <= maxIter
+ * \param progress is increased by the number of rotations done, may be read by other threads
+ * \return struct of type CycleInfo, found is false if no state repeats within maxIter rotations
+ */
+CycleInfo findCycle(const Byte* rotorShifts, const size_t maxIter, std::atomic<size_t>& progress);
+
+/*!
+ * \brief findCycles searches the cycles of several independent initial states in parallel
+ * \details The states are distributed over all logical processors. The calling thread prints the progress and the
+ * throughput regularly if verbose is set.
+ * \param states count * MAX_KEYLENGTH bytes, the initial rotor states
+ * \param count number of initial states
+ * \param maxIter maximal number of rotations for each state
+ * \param verbose print progress and throughput
+ * \return the CycleInfo of each state
+ */
+std::vector<CycleInfo> findCycles(const Byte* states, const size_t count, const size_t maxIter, const bool verbose);
+
+/*!
+ * \brief testCycles searches the cycles of the given keys in parallel and prints the results
+ * \param keys the keys to be tested
+ * \param maxIter maximal number of rotations for each key
+ */
+void testCycles(const std::vector<TuringaKey>& keys, const size_t maxIter);
@@ -0,0 +1,132 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file threadpool.hpp */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * class ThreadPool
+ * \brief long-lived worker threads executing small tasks with work stealing
+ * \details Every worker and the calling thread own a queue. Tasks are distributed round robin over the queues. A
+ * thread takes tasks from the front of its own queue and steals from the back of the others when its queue is empty.
+ * So a slow thread only delays the tasks it is currently working on. The calling thread submits all tasks and helps
+ * executing them in wait(). Each thread records how long it has been busy and idle.
+ */
+class ThreadPool {
+private:
+  /*!
+   * \struct Queue
+   * \brief The struct Queue holds the tasks and the statistics of one thread.
+   */
+  struct Queue {
+    std::mutex mutex;                         /**< protects tasks and statistics */
+    std::deque<std::function<void()>> tasks;  /**< tasks waiting for execution */
+    size_t executed = 0;                      /**< number of tasks executed by this thread */
+    size_t stolen   = 0;                      /**< number of those taken from other queues */
+    double busy     = 0;                      /**< seconds spent executing tasks */
+    double idle     = 0;                      /**< seconds spent waiting for tasks */
+  };
+
+  std::vector<std::unique_ptr<Queue>> p_queues;  /**< one queue per worker, the last one is the calling thread's */
+  std::vector<std::thread> p_threads;            /**< the worker threads */
+  std::mutex p_mutex;                            /**< protects the sleeping of the threads */
+  std::condition_variable p_wake;                /**< wakes workers when tasks are submitted */
+  std::condition_variable p_done;                /**< wakes the calling thread when all tasks are done */
+  std::atomic<size_t> p_queued;                  /**< number of tasks in all queues */
+  std::atomic<size_t> p_pending;                 /**< number of tasks submitted but not finished */
+  std::atomic<size_t> p_width;                   /**< number of threads taking part, including the calling one */
+  size_t p_next;                                 /**< queue receiving the next task */
+  bool p_stop;                                   /**< tells the workers to terminate */
+  std::exception_ptr p_failure;                  /**< first exception thrown by a task since the last wait() */
+
+  size_t queueIndex(const size_t i) const noexcept;
+  bool take(const size_t self, std::function<void()>& task);
+  void execute(const size_t self, std::function<void()>& task);
+  void work(const size_t self);
+
+public:
+  /*!
+   * \brief ThreadPool starts the worker threads
+   * \param workers number of worker threads besides the calling thread, 0 executes everything in wait()
+   */
+  explicit ThreadPool(const size_t workers);
+
+  /*!
+   * \brief submit appends a task to the next queue, only called by the thread owning the pool
+   * \param task function to be executed by any thread of the pool
+   */
+  void submit(std::function<void()> task);
+
+  /*!
+   * \brief limit restricts the following tasks to the first threads - 1 workers and the calling thread
+   * \details The other workers keep sleeping. Only called while no tasks are pending.
+   * \param threads number of threads, clamped to [1, size()]
+   */
+  void limit(const size_t threads);
+
+  /*!
+   * \brief pin binds every thread of the pool including the calling one to its own processor
+   * \details The processors are taken in order from the affinity mask of the process, so neighbouring threads share a
+   * NUMA node. Only implemented on Linux, elsewhere the threads stay unbound.
+   * \return number of threads pinned
+   */
+  size_t pin();
+
+  /*!
+   * \brief wait executes tasks in the calling thread until all submitted tasks are finished
+   * \details If tasks threw exceptions, the first one is rethrown after all tasks are finished.
+   */
+  void wait();
+
+  /*!
+   * \brief size returns the number of threads executing tasks
+   * \return the number of workers plus the calling thread
+   */
+  size_t size() const noexcept;
+
+  /*!
+   * \brief printStats prints the number of tasks and the busy and idle time of each thread since the last call
+   * \details Workers excluded by limit() are omitted.
+   */
+  void printStats();
+
+  /*!
+   * \brief ~ThreadPool terminates and joins the worker threads
+   */
+  ~ThreadPool();
+};
+
+/*!
+ * \brief threadPool returns the pool shared by all operations of the process
+ * \details The pool is created on the first call and reused afterwards, later values of workers are ignored. Use
+ * ThreadPool::limit to employ less threads.
+ * \param workers number of worker threads besides the calling thread
+ * \return reference to the pool
+ */
+ThreadPool& threadPool(const size_t workers);
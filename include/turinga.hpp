@@ -26,9 +26,8 @@
  * substitution cipher. Hence it's a symmetric encryption scheme.
  * \section sec2 What are the requirements of Turinga?
  * There is one version of the rotate function accelerated using AVX2 and another one accelerated
- * using SSE up to 4.1. So if you want to compile using one of these versions you need a processor
- * which supports AVX2 or SSE respectively and have to pass -march=native argument. This is set to
- * default by the CMakeLists.txt.
+ * using SSE up to 4.1. All versions are compiled into the binary and the best one supported by the
+ * processor is selected at startup. The option --kernel overrides this choice.
  * \section sec3 What should I care about when using Turinga?
  * \subsection sec3_1 Security aspects
  * Don't use short keys! Use at least length 8!
@@ -45,17 +44,23 @@
  */
 
 #include <cstddef>
+#include <functional>
 #include <string>
 
+#include "checkpoint.hpp"
+#include "options.hpp"
+#include "threadpool.hpp"
 #include "types.hpp"
+#include "workplan.hpp"
 
 /*!
  * \brief generates a pair of keys for encryption and decryption
  * \param keylength length of the key in use
  * \param availableRotors a std::string that represents the rotors, that can be used
+ * \param minCycle if not 0, initial rotor states whose states repeat within minCycle rotations are rejected
  * \return struct of type TuringaKey containing all infomation about the key
  */
-TuringaKey generateTuringaKey(const size_t keylength, const std::string& availableRotors);
+TuringaKey generateTuringaKey(const size_t keylength, const std::string& availableRotors, const size_t minCycle = 0);
 
 /*!
  * \brief createStdKey generate a key with standard name
@@ -65,6 +70,68 @@ TuringaKey generateTuringaKey(const size_t keylength, const std::string& availab
  */
 TuringaKey createStdKey();
 
+/*!
+ * \brief planEncrypt chooses the number of threads and the task size for encrypt
+ * \details The number of threads is limited by the --threads option or the available processors, in the chunked format
+ * also by the number of chunks. In the chunked format the task size is the chunk size.
+ * \param size number of bytes to be encrypted or decrypted
+ * \param key key used for encryption/ decryption
+ * \param options provides the thread limit and the execution mode
+ * \param header describes the layout of the data
+ * \return the plan encrypt will follow
+ */
+WorkPlan planEncrypt(const size_t size, const TuringaKey& key, const CryptOptions& options, const FileHeader& header);
+
+/*!
+ * \brief cryptPool returns the thread pool used by encrypt
+ * \param options provides the thread limit and the execution mode used when the pool is created
+ * \return reference to the pool
+ */
+ThreadPool& cryptPool(const CryptOptions& options);
+
+/*!
+ * \brief printCryptSetup prints the available processors, the kernel and the execution mode
+ * \param options provides the thread limit and the execution mode
+ */
+void printCryptSetup(const CryptOptions& options);
+
+/*!
+ * \brief printThroughput prints how fast the data has been processed
+ * \param size number of bytes processed
+ * \param duration time needed in seconds
+ */
+void printThroughput(const size_t size, const double duration);
+
+/*!
+ * \struct RangeIO
+ * \brief The struct RangeIO lets every task fetch its range of the data right before and store it right after the
+ * transformation.
+ * \details The functions receive the start of the window and the range [begin, end) of positions inside it. They are
+ * called by the threads of the pool at the same time, so they must only access their own range.
+ */
+struct RangeIO {
+  std::function<void(Byte*, size_t, size_t)> load;         /**< fills the range, empty if the data is in place */
+  std::function<void(Byte*, size_t, size_t)> store;        /**< passes the result on, empty to keep it in place */
+};
+
+/*!
+ * \brief encryptWindow encrypts or decrypts a contiguous part of the data
+ * \details The work is distributed like in encrypt, but nothing is printed. This allows to process files, which don't
+ * fit into memory, window by window. If io is given, each thread loads its range right before transforming it and
+ * stores it afterwards, so reading and writing the files overlaps with the work of the other threads.
+ * \param bytes the part of the data, receives the result
+ * \param offset position of the first byte within the whole data
+ * \param key key used for encryption/ decryption, its rotorShifts are the initial state of the whole data
+ * \param rotors stores the rotors (byte permutations) used
+ * \param options provides the thread limit and the execution mode
+ * \param header describes the layout of the data
+ * \param cache provides the rotor states in the legacy format, unused and may be nullptr in the chunked format
+ * \param io loads and stores the ranges of the tasks, nullptr transforms bytes in place
+ */
+void encryptWindow(
+  Data& bytes, const size_t offset, const TuringaKey& key, const Byte* rotors, const CryptOptions& options,
+  const FileHeader& header, CheckpointCache* cache, const RangeIO* io = nullptr);
+
 /*!
  * \brief encrypts or decrypts the data
  * \details The function iterates through the data and through the rotors and performs the
@@ -72,16 +139,37 @@ TuringaKey createStdKey();
  * \param bytes data to be encrypted/ decrypted
  * \param key key used for encryption/ decryption
  * \param rotors stores the rotors (byte permutations) used
+ * \param options provides the settings of the checkpoint cache used to find the start of each thread and the
+ * execution mode
+ * \param header describes the layout of the data, in the chunked format each chunk starts with a derived rotor state
+ * \param io loads and stores the ranges of the tasks, nullptr transforms bytes in place
+ */
+void encrypt(
+  Data& bytes, TuringaKey& key, const Byte* rotors, const CryptOptions& options, const FileHeader& header,
+  const RangeIO* io = nullptr);
+
+/*!
+ * \brief deriveChunkShifts computes the rotor state at the start of a chunk in the chunked format
+ * \details The initial rotorShifts of the key and the index of the chunk are used as key and nonce of ChaCha.
+ * The first MAX_KEYLENGTH bytes of the keystream are taken as rotor state. So every chunk can be encrypted
+ * independently of the others.
+ * \param rotorShifts MAX_KEYLENGTH bytes where the derived state is written to
+ * \param keyShifts initial rotorShifts of the key
+ * \param chunk index of the chunk
  */
-void encrypt(Data& bytes, TuringaKey& key, const Byte* rotors);
+void deriveChunkShifts(Byte* rotorShifts, const Byte* keyShifts, const uint64_t chunk);
 
 /*!
  * \brief does the same as encrypt, but only from position begin to position end
  * \details This function is designed to split the data and encrypt/ decrypt it parallel in several threads.
+ * The substitution is done by the kernel selected at startup.
  * \param bytes data from were a block should be encrypted or decrypted
  * \param key key used for encryption/ decryption
  * \param rotors stores the rotors (byte permutations) used
+ * \param options selects the interleaved or pipelined mode and the size of the pipeline
  * \param begin position to begin the encryption/ decryption; Position begin is included.
  * \param end position to end the encryption/ decryption; Position end is excluded.
  */
-void encrypt_block(Data& bytes, TuringaKey key, const Byte* rotors, const size_t begin, const size_t end);
+void encrypt_block(
+  Data& bytes, TuringaKey key, const Byte* rotors, const CryptOptions& options, const size_t begin,
+  const size_t end);
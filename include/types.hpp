@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 
 using Byte = unsigned char; /**< To simplify expressions use the intuitive definition. */
@@ -27,6 +28,53 @@ using Byte = unsigned char; /**< To simplify expressions use the intuitive defin
  */
 enum Direction { encryption = 0, decryption = 1 };
 
+/*!
+ * \brief enum Format specifies the layout of an encrypted file
+ */
+enum Format { legacy = 1, chunked = 2, framed = 3 };
+
+/*!
+ * \brief enum Mode specifies how the work is split between threads
+ * \details In the interleaved mode each thread steps the rotors and substitutes its bytes. In the pipelined mode each
+ * substitution thread gets a stepping thread, which computes the rotor states ahead.
+ */
+enum Mode { interleaved = 0, pipelined = 1 };
+
+/*!
+ * \brief enum Placement specifies where the memory of the data is located
+ * \details heap uses malloc. local maps the data on huge pages, the threads are pinned to processors and every thread
+ * faults in the pages it is going to work on, so they are placed on its own NUMA node.
+ */
+enum Placement { heap = 0, local = 1 };
+
+/*!
+ * \brief enum IOBackend specifies how files are read and written
+ * \details stdio copies the file into a buffer and back, mapped transforms the input mapping directly into the output
+ * mapping. uring keeps several windows in flight with io_uring while the others are transformed.
+ */
+enum IOBackend { stdio = 0, mapped = 1, uring = 2 };
+
+/*!
+ * \brief enum Pages specifies how a buffer has been allocated
+ */
+enum Pages { heapMemory = 0, mappedPages = 1, transparentHugePages = 2, explicitHugePages = 3 };
+
+/*!
+ * \struct FileHeader
+ * \brief The struct FileHeader describes the layout of encrypted data.
+ * \details Files in the legacy format have no header on disk, the rotor state of each byte follows from the one before.
+ * Files in the chunked format start with the magic bytes followed by version, chunk size and original size. The rotor
+ * state at the start of each chunk is derived from the key and the index of the chunk. Streams in the framed format
+ * start with the same header with original size 0, because the size isn't known in advance. Frames of a 64 bit length
+ * and that many bytes follow, an empty frame ends the stream. The chunks are encrypted like in the chunked format, but
+ * the fileShift isn't applied.
+ */
+struct FileHeader {
+  Format version;        /**< format of the file, the version number is stored in the header */
+  uint64_t chunkSize;    /**< number of bytes per chunk, only used by the chunked format */
+  uint64_t originalSize; /**< size of the data without header */
+};
+
 /*!
  * \struct Data
  * \brief The struct Data is a simple array and it's length.
@@ -50,6 +98,7 @@ struct TuringaKey {
   Byte* rotorShifts;   /**< It's an array of bytes that stores current position of the wheels. This
                           will be changed by the rotate function after each encrypted Byte */
   size_t fileShift;    /**< the bytes will be shifted (mod filesize) by fileShift */
+  uint64_t rotorHash = 0; /**< fingerprint of the rotor set the key was generated with, 0 if unknown */
 };
 
 /*!
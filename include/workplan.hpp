@@ -0,0 +1,64 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*! \file workplan.hpp */
+
+#include <cstddef>
+
+/*!
+ * \struct CostModel
+ * \brief The struct CostModel holds the measured costs of the selected kernel in seconds.
+ * \details Substituting n bytes with a key of length l takes about n * (perByte + l * perRotor), walking the rotate
+ * chain over n positions n * perStep.
+ */
+struct CostModel {
+  double perByte;  /**< cost of a position independent of the key length */
+  double perRotor; /**< additional cost of each rotor per position */
+  double perStep;  /**< cost of a single rotate step in advance */
+};
+
+/*!
+ * \struct WorkPlan
+ * \brief The struct WorkPlan describes how the work on a file is distributed.
+ */
+struct WorkPlan {
+  size_t threads;  /**< number of threads taking part, 1 runs everything in the calling thread */
+  size_t taskSize; /**< number of bytes per task in the legacy format */
+  double duration; /**< estimated sequential computation time in seconds */
+};
+
+/*!
+ * \brief costModel measures the costs of the selected kernel on the first call
+ * \return reference to the measured costs
+ */
+const CostModel& costModel();
+
+/*!
+ * \brief planWork chooses the number of threads and the task size for a file
+ * \details Small files are processed by the calling thread without measuring anything. Otherwise every task is
+ * large enough to outweigh the scheduling overhead and every thread gets several tasks to balance the load. In the
+ * legacy format the rotor states at the task boundaries are walked sequentially, threads that would wait for this
+ * walk are not employed.
+ * \param size number of bytes to be encrypted or decrypted
+ * \param keylength number of rotors in the key
+ * \param maxThreads upper limit of the number of threads
+ * \param walk whether the start states of the tasks are found by walking the rotate chain
+ * \return the plan
+ */
+WorkPlan planWork(const size_t size, const size_t keylength, const size_t maxThreads, const bool walk);
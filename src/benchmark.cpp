@@ -0,0 +1,165 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "benchmark.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "chacha.hpp"
+#include "constants.hpp"
+#include "kernels.hpp"
+#include "measurement.hpp"
+#include "rotate.hpp"
+#include "substitute.hpp"
+
+static const double MIN_DURATION       = 0.2;                          /**< minimal duration of a measurement in s */
+static const size_t BENCH_BYTES        = 1 << 20;                      /**< number of bytes substituted per round */
+static const size_t BENCH_KEYLENGTHS[] = {1, 4, 8, 10, 16, 24, 32};  /**< key lengths shown by the benchmark */
+
+// calls function with doubling rounds until it takes long enough, returns the rounds per second
+template <typename Function>
+static double measure(Function function) {
+  for (size_t rounds = 1;; rounds *= 2) {
+    const time_point start = std::chrono::high_resolution_clock::now();
+    function(rounds);
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    if (duration.count() >= MIN_DURATION) {
+      return rounds / duration.count();
+    }
+  }
+}
+
+void benchmarkRotate(const size_t count) {
+  const KernelTable selected = KERNELS;
+  std::vector<Byte> states(count * MAX_KEYLENGTH);
+  for (size_t i = 0; i < states.size(); ++i) {
+    states[i] = i * 131 + 17;
+  }
+
+  std::cout << timestamp(current_duration()) << "Benchmark of rotate, " << count
+            << " independent states for rotate_n.\n";
+  for (const Kernel kernel : {generic, sse4, avx2, avx512}) {
+    if (!kernelSupported(kernel)) {
+      continue;
+    }
+    selectKernel(kernelName(kernel));
+    const double single = measure([&](const size_t rounds) { advance(states.data(), rounds); });
+    const double many   = count * measure([&](const size_t rounds) {
+                          for (size_t round = 0; round < rounds; ++round) {
+                            rotate_n(states.data(), count);
+                          }
+                        });
+    std::cout << timestamp(current_duration()) << std::setw(8) << kernelName(kernel) << ": advance "
+              << std::setprecision(3) << single / 1e6 << " M states/s, rotate_n " << many / 1e6 << " M states/s\n";
+  }
+  KERNELS = selected;
+}
+
+void benchmarkSubstitute() {
+  const KernelTable selected = KERNELS;
+  std::vector<Byte> bytes(BENCH_BYTES);
+  std::vector<Byte> rotors(ROTOR_MEMORY);
+  for (size_t i = 0; i < 256 * MAX_KEYLENGTH; ++i) {
+    rotors[i] = i * 167 + 13;
+  }
+  deriveRotorTables(rotors.data(), MAX_KEYLENGTH);
+  Byte rotorShifts[MAX_KEYLENGTH] = {0};
+  TuringaKey key{encryption, 0, nullptr, rotorShifts, 0};
+
+  std::cout << timestamp(current_duration())
+            << "Benchmark of the substitution in MB/s, loop over the rotors / unrolled for the key length, kernels "
+               "without unrolled variants show only the loop:\n";
+  std::cout << std::setw(8) << "length";
+  for (const size_t length : BENCH_KEYLENGTHS) {
+    std::cout << std::setw(15) << length;
+  }
+  std::cout << "\n";
+  for (const Kernel kernel : {generic, sse4, avx2, avx512}) {
+    if (!kernelSupported(kernel)) {
+      continue;
+    }
+    selectKernel(kernelName(kernel));
+    std::cout << std::setw(8) << kernelName(kernel);
+    // the vector kernels return the same function for both variants
+    const bool unrolled = (substituteVariant(kernel, false) != substituteVariant(kernel, true));
+    for (const size_t length : BENCH_KEYLENGTHS) {
+      key.length = length;
+      double speed[2];
+      for (const bool specialised : {false, true}) {
+        if (specialised && !unrolled) {
+          continue;
+        }
+        const SubstituteFunction function = substituteVariant(kernel, specialised);
+        speed[specialised] = BENCH_BYTES * measure([&](const size_t rounds) {
+                               for (size_t round = 0; round < rounds; ++round) {
+                                 function(bytes.data(), bytes.size(), key, rotors.data());
+                               }
+                             });
+      }
+      std::cout << std::fixed << std::setprecision(0);
+      if (unrolled) {
+        std::cout << std::setw(7) << speed[0] / 1e6 << " /" << std::setw(6) << speed[1] / 1e6;
+      }
+      else {
+        std::cout << std::setw(15) << speed[0] / 1e6;
+      }
+    }
+    std::cout << std::defaultfloat << "\n";
+  }
+  KERNELS = selected;
+}
+
+void benchmarkChaCha() {
+  const KernelTable selected = KERNELS;
+  std::vector<Byte> keystream(BENCH_BYTES);
+  uint32_t seed[12];
+  expandSeed(seed, 0);
+
+  // get() keeps only the first word of every block
+  ChaCha single;
+  single.init(seed);
+  const double words = measure([&](const size_t rounds) {
+    uint32_t sum = 0;
+    for (size_t round = 0; round < rounds; ++round) {
+      sum += single.get();
+    }
+    keystream[0] = sum;
+  });
+  std::cout << timestamp(current_duration()) << "Benchmark of ChaCha, get " << std::fixed << std::setprecision(0)
+            << 4 * words / 1e6 << " MB/s of used keystream, generate:\n"
+            << std::defaultfloat;
+  for (const Kernel kernel : {generic, sse4, avx2, avx512}) {
+    if (!kernelSupported(kernel)) {
+      continue;
+    }
+    selectKernel(kernelName(kernel));
+    ChaCha rng;
+    rng.init(seed);
+    const double speed = BENCH_BYTES * measure([&](const size_t rounds) {
+                           for (size_t round = 0; round < rounds; ++round) {
+                             rng.generate(keystream.data(), keystream.size());
+                           }
+                         });
+    std::cout << timestamp(current_duration()) << std::setw(8) << kernelName(kernel) << ": " << std::fixed
+              << std::setprecision(0) << speed / 1e6 << " MB/s\n"
+              << std::defaultfloat;
+  }
+  KERNELS = selected;
+}
@@ -0,0 +1,120 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "buffer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "constants.hpp"
+
+#ifdef __linux__
+// size of a mapping with explicit huge pages, which must be a multiple of the huge page size
+static size_t hugeSize(const size_t size) {
+  return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+#endif
+
+Byte* allocateBytes(const size_t size, const Placement placement, Pages& pages) {
+  pages = heapMemory;
+#ifdef __linux__
+  if (placement == local && size > 0) {
+    // explicit huge pages need a reserved pool (vm.nr_hugepages), so they fail on most systems. The pages are
+    // reserved by mmap, with MAP_NORESERVE a missing page would only show up as SIGBUS on the first touch.
+    void* memory =
+      mmap(nullptr, hugeSize(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+      pages = explicitHugePages;
+      return static_cast<Byte*>(memory);
+    }
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+      pages = (madvise(memory, size, MADV_HUGEPAGE) == 0) ? transparentHugePages : mappedPages;
+      return static_cast<Byte*>(memory);
+    }
+  }
+#else
+  (void) placement;
+#endif
+  return (Byte*) malloc(size);
+}
+
+void freeBytes(Byte* bytes, const size_t size, const Pages pages) {
+#ifdef __linux__
+  if (pages != heapMemory) {
+    munmap(bytes, (pages == explicitHugePages) ? hugeSize(size) : size);
+    return;
+  }
+#else
+  (void) size;
+  (void) pages;
+#endif
+  free(bytes);
+}
+
+Buffer::Buffer(const size_t size, const Placement placement)
+  : p_bytes(nullptr), p_size(size), p_pages(heapMemory) {
+  p_bytes = allocateBytes(size, placement, p_pages);
+}
+
+Buffer::Buffer(Buffer&& other) noexcept : p_bytes(other.p_bytes), p_size(other.p_size), p_pages(other.p_pages) {
+  other.p_bytes = nullptr;
+}
+
+Byte* Buffer::bytes() const noexcept {
+  return p_bytes;
+}
+
+Pages Buffer::pages() const noexcept {
+  return p_pages;
+}
+
+Buffer::~Buffer() {
+  if (p_bytes) {
+    freeBytes(p_bytes, p_size, p_pages);
+  }
+}
+
+void firstTouch(Data& bytes, ThreadPool& pool, const size_t taskSize) {
+  for (size_t begin = 0; begin < bytes.size; begin += taskSize) {
+    const size_t end = std::min(begin + taskSize, bytes.size);
+    pool.submit([&bytes, begin, end]() {
+      // one write per page is enough to fault it in
+      for (size_t i = begin; i < end; i += PAGE_SIZE) {
+        bytes.bytes[i] = 0;
+      }
+    });
+  }
+  pool.wait();
+}
+
+const char* pagesName(const Pages pages) {
+  switch (pages) {
+  case explicitHugePages:
+    return "explicit huge pages";
+  case transparentHugePages:
+    return "transparent huge pages";
+  case mappedPages:
+    return "mapped normal pages";
+  default:
+    return "heap memory";
+  }
+}
@@ -1,6 +1,6 @@
 /*
  * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
- * Copyright (C) 2022 Mathemalsky, MilchRatchet
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -15,77 +15,179 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
-
 #include "chacha.hpp"
 
 #include <cstring>
 
-#include "types.hpp"
-
-// implementation related to:
-// https://stackoverflow.com/questions/776508/best-practices-for-circular-shift-rotate-operations-in-c
-static inline uint32_t rotleft(const uint32_t integer, unsigned int count) {
-  const unsigned int cutof = 31;
-  count &= cutof;  // shifts larger than 31 bits are not needed in a 32 bit integer
-  return (integer << count | integer >> ((-count) & cutof));
+#if defined(KERNEL_X86)
+#include <immintrin.h>
+#endif
+
+void ChaCha::generate(Byte* buffer, const size_t length) {
+  const size_t blocks = length / 64;
+  KERNELS.chacha(pState, blocks, buffer);
+  pState[12] += blocks;
+  if (length % 64 != 0) {
+    uint32_t output[16];
+    block(output);
+    ++pState[12];
+    std::memcpy(buffer + 64 * blocks, output, length % 64);
+  }
 }
 
-static inline void quaterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
-  a += b;
-  d ^= a;
-  d = rotleft(d, 16);
-
-  c += d;
-  b ^= c;
-  b = rotleft(b, 12);
-
-  a += b;
-  d ^= a;
-  d = rotleft(d, 8);
-
-  c += d;
-  b ^= c;
-  b = rotleft(b, 7);
+static void chacha_generic(const uint32_t* state, const size_t count, Byte* output) {
+  ChaCha rng;
+  rng.init(state + 4);
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t words[16];
+    rng.block(words);
+    rng.get();
+    std::memcpy(output + 64 * i, words, 64);
+  }
 }
 
-void ChaCha::init(const uint32_t* seed) {
-  std::memcpy(pState, &expand_32_byte_k[0], 16);  // copy the constant in the key
-  std::memcpy(pState + 4, seed, 48);              // 48 = 12 * 4 Byte
+#if defined(KERNEL_X86)
+// every register holds one word of 4 blocks, so the quarter rounds of the blocks run side by side
+TARGET_SSE4 static inline __m128i rotleft_sse4(const __m128i word, const int count) {
+  return _mm_or_si128(_mm_slli_epi32(word, count), _mm_srli_epi32(word, 32 - count));
 }
 
-uint32_t ChaCha::get() {
-  uint32_t workingState[16];
-  std::memcpy(&workingState[0], &pState[0], 64);
-
-  for (unsigned int i = 0; i < DOUBLE_ROUNDS; ++i) {
-    // uneven rounds
-    quaterRound(workingState[0], workingState[4], workingState[8], workingState[12]);
-    quaterRound(workingState[1], workingState[5], workingState[9], workingState[13]);
-    quaterRound(workingState[2], workingState[6], workingState[10], workingState[14]);
-    quaterRound(workingState[3], workingState[7], workingState[11], workingState[15]);
+TARGET_SSE4 static inline void quaterRound_sse4(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+  const __m128i rot16 = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  const __m128i rot8  = _mm_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+  a                   = _mm_add_epi32(a, b);
+  d                   = _mm_shuffle_epi8(_mm_xor_si128(d, a), rot16);
+  c                   = _mm_add_epi32(c, d);
+  b                   = rotleft_sse4(_mm_xor_si128(b, c), 12);
+  a                   = _mm_add_epi32(a, b);
+  d                   = _mm_shuffle_epi8(_mm_xor_si128(d, a), rot8);
+  c                   = _mm_add_epi32(c, d);
+  b                   = rotleft_sse4(_mm_xor_si128(b, c), 7);
+}
 
-    // even rounds
-    quaterRound(workingState[0], workingState[5], workingState[10], workingState[15]);
-    quaterRound(workingState[1], workingState[6], workingState[11], workingState[12]);
-    quaterRound(workingState[2], workingState[7], workingState[8], workingState[13]);
-    quaterRound(workingState[3], workingState[4], workingState[9], workingState[14]);
+TARGET_SSE4 static void chacha_sse4(const uint32_t* state, const size_t count, Byte* output) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i original[16];
+    for (size_t w = 0; w < 16; ++w) {
+      original[w] = _mm_set1_epi32(state[w]);
+    }
+    original[12] = _mm_add_epi32(_mm_set1_epi32(state[12] + i), _mm_setr_epi32(0, 1, 2, 3));
+    __m128i x[16];
+    for (size_t w = 0; w < 16; ++w) {
+      x[w] = original[w];
+    }
+    for (unsigned int round = 0; round < 10; ++round) {
+      quaterRound_sse4(x[0], x[4], x[8], x[12]);
+      quaterRound_sse4(x[1], x[5], x[9], x[13]);
+      quaterRound_sse4(x[2], x[6], x[10], x[14]);
+      quaterRound_sse4(x[3], x[7], x[11], x[15]);
+      quaterRound_sse4(x[0], x[5], x[10], x[15]);
+      quaterRound_sse4(x[1], x[6], x[11], x[12]);
+      quaterRound_sse4(x[2], x[7], x[8], x[13]);
+      quaterRound_sse4(x[3], x[4], x[9], x[14]);
+    }
+    // transposes groups of 4 words, so each register holds 16 consecutive bytes of one block
+    for (size_t w = 0; w < 16; w += 4) {
+      const __m128i a  = _mm_add_epi32(x[w], original[w]);
+      const __m128i b  = _mm_add_epi32(x[w + 1], original[w + 1]);
+      const __m128i c  = _mm_add_epi32(x[w + 2], original[w + 2]);
+      const __m128i d  = _mm_add_epi32(x[w + 3], original[w + 3]);
+      const __m128i ab = _mm_unpacklo_epi32(a, b), cd = _mm_unpacklo_epi32(c, d);
+      const __m128i AB = _mm_unpackhi_epi32(a, b), CD = _mm_unpackhi_epi32(c, d);
+      Byte* block      = output + 64 * i + 4 * w;
+      _mm_storeu_si128((__m128i*) block, _mm_unpacklo_epi64(ab, cd));
+      _mm_storeu_si128((__m128i*) (block + 64), _mm_unpackhi_epi64(ab, cd));
+      _mm_storeu_si128((__m128i*) (block + 128), _mm_unpacklo_epi64(AB, CD));
+      _mm_storeu_si128((__m128i*) (block + 192), _mm_unpackhi_epi64(AB, CD));
+    }
   }
-
-  // add original state to current
-  for (unsigned int i = 0; i < 16; ++i) {
-    workingState[i] += pState[i];
+  if (i < count) {
+    uint32_t rest[16];
+    std::memcpy(rest, state, sizeof(rest));
+    rest[12] += i;
+    chacha_generic(rest, count - i, output + 64 * i);
   }
+}
 
-  // increase counter by one
-  ++pState[12];
+// the same with 8 blocks, the lower 128 bits of a register belong to blocks 0 - 3 and the upper ones to blocks 4 - 7
+TARGET_AVX2 static inline __m256i rotleft_avx2(const __m256i word, const int count) {
+  return _mm256_or_si256(_mm256_slli_epi32(word, count), _mm256_srli_epi32(word, 32 - count));
+}
 
-  // return, theoreticly all 64 byte
-  return workingState[0];
+TARGET_AVX2 static inline void quaterRound_avx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+  const __m256i rot16 = _mm256_setr_epi8(
+    2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  const __m256i rot8 = _mm256_setr_epi8(
+    3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+  a = _mm256_add_epi32(a, b);
+  d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16);
+  c = _mm256_add_epi32(c, d);
+  b = rotleft_avx2(_mm256_xor_si256(b, c), 12);
+  a = _mm256_add_epi32(a, b);
+  d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8);
+  c = _mm256_add_epi32(c, d);
+  b = rotleft_avx2(_mm256_xor_si256(b, c), 7);
 }
 
-void expandSeed(uint32_t* seed, const uint64_t src) {
-  Byte* byteSeed = (Byte*) seed;
-  for (unsigned int i = 0; i < 48; i += 8) {
-    std::memcpy(byteSeed + i, &src, 8);
+TARGET_AVX2 static void chacha_avx2(const uint32_t* state, const size_t count, Byte* output) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i original[16];
+    for (size_t w = 0; w < 16; ++w) {
+      original[w] = _mm256_set1_epi32(state[w]);
+    }
+    original[12] = _mm256_add_epi32(_mm256_set1_epi32(state[12] + i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i x[16];
+    for (size_t w = 0; w < 16; ++w) {
+      x[w] = original[w];
+    }
+    for (unsigned int round = 0; round < 10; ++round) {
+      quaterRound_avx2(x[0], x[4], x[8], x[12]);
+      quaterRound_avx2(x[1], x[5], x[9], x[13]);
+      quaterRound_avx2(x[2], x[6], x[10], x[14]);
+      quaterRound_avx2(x[3], x[7], x[11], x[15]);
+      quaterRound_avx2(x[0], x[5], x[10], x[15]);
+      quaterRound_avx2(x[1], x[6], x[11], x[12]);
+      quaterRound_avx2(x[2], x[7], x[8], x[13]);
+      quaterRound_avx2(x[3], x[4], x[9], x[14]);
+    }
+    for (size_t w = 0; w < 16; w += 4) {
+      const __m256i a  = _mm256_add_epi32(x[w], original[w]);
+      const __m256i b  = _mm256_add_epi32(x[w + 1], original[w + 1]);
+      const __m256i c  = _mm256_add_epi32(x[w + 2], original[w + 2]);
+      const __m256i d  = _mm256_add_epi32(x[w + 3], original[w + 3]);
+      const __m256i ab = _mm256_unpacklo_epi32(a, b), cd = _mm256_unpacklo_epi32(c, d);
+      const __m256i AB = _mm256_unpackhi_epi32(a, b), CD = _mm256_unpackhi_epi32(c, d);
+      const __m256i words[4] = {
+        _mm256_unpacklo_epi64(ab, cd), _mm256_unpackhi_epi64(ab, cd), _mm256_unpacklo_epi64(AB, CD),
+        _mm256_unpackhi_epi64(AB, CD)};
+      Byte* block = output + 64 * i + 4 * w;
+      for (size_t j = 0; j < 4; ++j) {
+        _mm_storeu_si128((__m128i*) (block + 64 * j), _mm256_castsi256_si128(words[j]));
+        _mm_storeu_si128((__m128i*) (block + 64 * (j + 4)), _mm256_extracti128_si256(words[j], 1));
+      }
+    }
+  }
+  if (i < count) {
+    uint32_t rest[16];
+    std::memcpy(rest, state, sizeof(rest));
+    rest[12] += i;
+    chacha_sse4(rest, count - i, output + 64 * i);
+  }
+}
+#endif
+
+ChaChaFunction chachaVariant(const Kernel kernel) {
+  switch (kernel) {
+#if defined(KERNEL_X86)
+  case avx512:
+  case avx2:
+    return chacha_avx2;
+  case sse4:
+    return chacha_sse4;
+#endif
+  default:
+    return chacha_generic;
   }
 }
@@ -0,0 +1,238 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "checkpoint.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "colors.hpp"
+#include "measurement.hpp"
+#include "rotate.hpp"
+
+static const char CHECKPOINT_MAGIC[4] = {'T', 'C', 'K', '2'};
+static const size_t CHECKPOINT_HEADER = sizeof(CHECKPOINT_MAGIC) + 3 * sizeof(uint64_t);  // interval, count, checksum
+
+uint64_t fingerprint(const Byte* data, const size_t length) {
+  uint64_t hash = 0xcbf29ce484222325;  // FNV offset basis
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= data[i];
+    hash *= 0x100000001b3;  // FNV prime
+  }
+  return hash;
+}
+
+CheckpointCache::CheckpointCache(const Byte* rotorShifts, const CryptOptions& options)
+  : p_cursorPosition(0)
+  , p_interval(options.checkpointInterval)
+  , p_sizeCap(options.cacheSize)
+  , p_directory(options.cacheDir)
+  , p_loaded(0)
+  , p_requested(0)
+  , p_walked(0) {
+  std::memcpy(p_cursor, rotorShifts, MAX_KEYLENGTH);
+  p_checkpoints.assign(rotorShifts, rotorShifts + MAX_KEYLENGTH);  // checkpoint 0 is the initial state
+  if (p_interval == 0) {
+    return;
+  }
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.chk", (unsigned long long) fingerprint(rotorShifts, MAX_KEYLENGTH));
+  p_filename = p_directory + name;
+  load(rotorShifts);
+}
+
+void CheckpointCache::load(const Byte* rotorShifts) {
+  std::error_code error;
+  const uint64_t fileSize = std::filesystem::file_size(p_filename, error);
+  if (error || fileSize < CHECKPOINT_HEADER) {
+    return;
+  }
+  FILE* myfile = fopen(p_filename.c_str(), "rb");
+  if (!myfile) {
+    return;
+  }
+  char magic[sizeof(CHECKPOINT_MAGIC)];
+  uint64_t interval = 0, count = 0, checksum = 0;
+  size_t size = fread(magic, 1, sizeof(magic), myfile);
+  size += fread(&interval, sizeof(uint64_t), 1, myfile) * sizeof(uint64_t);
+  size += fread(&count, sizeof(uint64_t), 1, myfile) * sizeof(uint64_t);
+  size += fread(&checksum, sizeof(uint64_t), 1, myfile) * sizeof(uint64_t);
+
+  // a damaged file, a file with another interval or from another key is a cache miss and replaced on save, the count
+  // must match the size of the file, so it never allocates more than the file holds
+  std::vector<Byte> checkpoints;
+  if (
+    size == CHECKPOINT_HEADER && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0 && interval == p_interval
+    && count > 0 && count == (fileSize - CHECKPOINT_HEADER) / MAX_KEYLENGTH
+    && (fileSize - CHECKPOINT_HEADER) % MAX_KEYLENGTH == 0) {
+    checkpoints.resize(count * MAX_KEYLENGTH);
+    if (fread(checkpoints.data(), MAX_KEYLENGTH, count, myfile) != count) {
+      checkpoints.clear();
+    }
+  }
+  fclose(myfile);
+  if (
+    !checkpoints.empty() && fingerprint(checkpoints.data(), checkpoints.size()) == checksum
+    && std::memcmp(checkpoints.data(), rotorShifts, MAX_KEYLENGTH) == 0) {
+    p_loaded      = checkpoints.size() / MAX_KEYLENGTH;
+    p_checkpoints = std::move(checkpoints);
+  }
+}
+
+void CheckpointCache::seek(Byte* rotorShifts, const size_t position) {
+  p_requested = std::max(p_requested, position);
+
+  // start from the nearest known state in front of position
+  size_t checkpoint = 0;
+  if (p_interval != 0) {
+    checkpoint = std::min(position / p_interval, p_checkpoints.size() / MAX_KEYLENGTH - 1);
+  }
+  if (checkpoint * p_interval > p_cursorPosition || p_cursorPosition > position) {
+    std::memcpy(p_cursor, p_checkpoints.data() + checkpoint * MAX_KEYLENGTH, MAX_KEYLENGTH);
+    p_cursorPosition = checkpoint * p_interval;
+  }
+
+  // walk to the next checkpoint or the position, whatever comes first
+  while (p_cursorPosition < position) {
+    size_t steps = position - p_cursorPosition;
+    if (p_interval != 0) {
+      steps = std::min(steps, p_interval - p_cursorPosition % p_interval);
+    }
+    advance(p_cursor, steps);
+    p_cursorPosition += steps;
+    p_walked += steps;
+    if (
+      p_interval != 0 && p_cursorPosition % p_interval == 0
+      && p_cursorPosition / p_interval == p_checkpoints.size() / MAX_KEYLENGTH) {
+      p_checkpoints.insert(p_checkpoints.end(), p_cursor, p_cursor + MAX_KEYLENGTH);
+    }
+  }
+  std::memcpy(rotorShifts, p_cursor, MAX_KEYLENGTH);
+}
+
+// creates a file only the owner may read and write, the cache files contain key material
+static FILE* createPrivate(const std::string& filename) {
+#ifdef _WIN32
+  const int descriptor = _open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+  return (descriptor < 0) ? nullptr : _fdopen(descriptor, "wb");
+#else
+  const int descriptor = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  return (descriptor < 0) ? nullptr : fdopen(descriptor, "wb");
+#endif
+}
+
+void CheckpointCache::save() {
+  if (p_interval == 0) {
+    return;
+  }
+  // never let a single file exceed the limit
+  const size_t maxCount = (p_sizeCap > CHECKPOINT_HEADER) ? (p_sizeCap - CHECKPOINT_HEADER) / MAX_KEYLENGTH : 0;
+  const uint64_t count  = std::min(p_checkpoints.size() / MAX_KEYLENGTH, maxCount);
+
+  std::error_code error;
+  if (std::filesystem::create_directories(p_directory, error)) {
+    std::filesystem::permissions(p_directory, std::filesystem::perms::owner_all, error);
+  }
+  if (count > p_loaded) {
+    // the file is replaced at once, so a crash never leaves a partly written cache file
+#ifdef _WIN32
+    const std::string temporary = p_filename + "." + std::to_string(_getpid()) + ".tmp";
+#else
+    const std::string temporary = p_filename + "." + std::to_string(getpid()) + ".tmp";
+#endif
+    const uint64_t checksum = fingerprint(p_checkpoints.data(), count * MAX_KEYLENGTH);
+    FILE* myfile            = createPrivate(temporary);
+    bool written            = (myfile != nullptr);
+    if (myfile) {
+      written = fwrite(CHECKPOINT_MAGIC, 1, sizeof(CHECKPOINT_MAGIC), myfile) == sizeof(CHECKPOINT_MAGIC);
+      written = written && fwrite(&p_interval, sizeof(uint64_t), 1, myfile) == 1;
+      written = written && fwrite(&count, sizeof(uint64_t), 1, myfile) == 1;
+      written = written && fwrite(&checksum, sizeof(uint64_t), 1, myfile) == 1;
+      written = written && fwrite(p_checkpoints.data(), MAX_KEYLENGTH, count, myfile) == count;
+      written = (fclose(myfile) == 0) && written;
+    }
+    if (written) {
+      std::filesystem::rename(temporary, p_filename, error);
+      written = !error;
+    }
+    if (!written) {
+      std::filesystem::remove(temporary, error);
+      std::cout << timestamp(current_duration());
+      print_yellow("Warning: ");
+      std::cout << "Couldn't write checkpoint cache <" << p_filename << ">.\n";
+      return;
+    }
+  }
+  else if (p_loaded > 0) {
+    // mark the file as recently used
+    std::filesystem::last_write_time(p_filename, std::filesystem::file_time_type::clock::now(), error);
+  }
+  evict();
+}
+
+void CheckpointCache::evict() const {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  std::vector<fs::directory_entry> files;
+  size_t totalSize = 0;
+  for (const fs::directory_entry& entry : fs::directory_iterator(p_directory, error)) {
+    if (entry.is_regular_file(error) && entry.path().extension() == ".chk") {
+      files.push_back(entry);
+      totalSize += entry.file_size(error);
+    }
+  }
+
+  // remove least recently used files first
+  std::sort(files.begin(), files.end(), [](const fs::directory_entry& a, const fs::directory_entry& b) {
+    std::error_code error;
+    return a.last_write_time(error) < b.last_write_time(error);
+  });
+  for (const fs::directory_entry& entry : files) {
+    if (totalSize <= p_sizeCap) {
+      break;
+    }
+    if (entry.path() == fs::path(p_filename)) {
+      continue;
+    }
+    totalSize -= entry.file_size(error);
+    fs::remove(entry.path(), error);
+  }
+}
+
+void CheckpointCache::printStats() const {
+  if (p_interval == 0) {
+    return;
+  }
+  const size_t saved = (p_requested > p_walked) ? p_requested - p_walked : 0;
+  std::cout << timestamp(current_duration()) << "Checkpoint cache saved " << saved << " of "
+            << p_requested << " rotate steps (" << p_loaded << " checkpoints loaded, "
+            << p_checkpoints.size() / MAX_KEYLENGTH << " known).\n";
+}
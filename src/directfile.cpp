@@ -0,0 +1,172 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "directfile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "constants.hpp"
+#include "errors.hpp"
+#include "measurement.hpp"
+
+// largest multiple of DIRECT_ALIGNMENT not above position
+static uint64_t alignDown(const uint64_t position) {
+  return position / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+}
+
+// smallest multiple of DIRECT_ALIGNMENT not below position
+static uint64_t alignUp(const uint64_t position) {
+  return alignDown(position + DIRECT_ALIGNMENT - 1);
+}
+
+// seconds elapsed since start
+static double elapsed(const time_point start) {
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+DirectFile::DirectFile(const char* filename, const bool write, const size_t transfer) :
+  p_direct(-1), p_buffered(-1), p_error(ENOSYS), p_stage(nullptr), p_stageSize(alignUp(std::max<size_t>(transfer, 1))),
+  p_directBytes(0), p_bufferedBytes(0), p_seconds(0), p_filename(filename) {
+#ifdef O_DIRECT
+  if (write) {
+    // creates the file, the direct descriptor must not truncate it again
+    p_buffered = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (p_buffered < 0) {
+      throw CannotCreateFile("DirectFile", filename);
+    }
+  }
+  p_direct = open(filename, (write ? O_WRONLY : O_RDONLY) | O_DIRECT);
+  if (p_direct < 0) {
+    p_error = errno;
+    if (!write) {
+      // distinguishes a missing file from a file system without O_DIRECT
+      const int probe = open(filename, O_RDONLY);
+      if (probe < 0) {
+        throw FileNotFound("DirectFile", filename);
+      }
+      close(probe);
+    }
+    return;
+  }
+  void* stage = nullptr;
+  if (posix_memalign(&stage, DIRECT_ALIGNMENT, p_stageSize) != 0) {
+    throw FileAccessFailed("DirectFile", filename, "allocate staging buffer for");
+  }
+  p_stage = static_cast<Byte*>(stage);
+#else
+  (void) write;
+#endif
+}
+
+void DirectFile::read(Byte* bytes, const size_t length, const uint64_t offset) {
+#ifdef O_DIRECT
+  const time_point start = std::chrono::high_resolution_clock::now();
+  const uint64_t end     = offset + length;
+  uint64_t position      = alignDown(offset);
+  while (position < end) {
+    const size_t request = std::min<uint64_t>(p_stageSize, alignUp(end) - position);
+    const auto count     = pread(p_direct, p_stage, request, position);
+    // a direct read only returns less than an aligned request at the end of the file
+    if (count <= 0 || (count % DIRECT_ALIGNMENT != 0 && position + count < end)) {
+      throw FileAccessFailed("DirectFile::read", p_filename, "read");
+    }
+    const uint64_t from = std::max(position, offset);
+    const uint64_t to   = std::min<uint64_t>(position + count, end);
+    std::memcpy(bytes + (from - offset), p_stage + (from - position), to - from);
+    p_directBytes += count;
+    position += count;
+  }
+  p_seconds += elapsed(start);
+#else
+  (void) bytes;
+  (void) length;
+  (void) offset;
+  throw FileAccessFailed("DirectFile::read", p_filename, "read");
+#endif
+}
+
+void DirectFile::write(const Byte* bytes, const size_t length, const uint64_t offset) {
+#ifdef O_DIRECT
+  const time_point start = std::chrono::high_resolution_clock::now();
+  const uint64_t end     = offset + length;
+  // [head, tail) are the whole blocks inside the range, the bytes around them share blocks with other writes
+  const uint64_t head = std::min(alignUp(offset), end);
+  const uint64_t tail = std::max(alignDown(end), head);
+  const auto buffered = [&](const uint64_t from, const uint64_t to) {
+    for (uint64_t position = from; position < to;) {
+      const auto count = pwrite(p_buffered, bytes + (position - offset), to - position, position);
+      if (count <= 0) {
+        throw FileAccessFailed("DirectFile::write", p_filename, "write");
+      }
+      position += count;
+    }
+    p_bufferedBytes += to - from;
+  };
+  buffered(offset, head);
+  for (uint64_t position = head; position < tail;) {
+    const size_t request = std::min<uint64_t>(p_stageSize, tail - position);
+    std::memcpy(p_stage, bytes + (position - offset), request);
+    const auto count = pwrite(p_direct, p_stage, request, position);
+    if (count <= 0 || count % DIRECT_ALIGNMENT != 0) {
+      throw FileAccessFailed("DirectFile::write", p_filename, "write");
+    }
+    p_directBytes += count;
+    position += count;
+  }
+  buffered(tail, end);
+  p_seconds += elapsed(start);
+#else
+  (void) bytes;
+  (void) length;
+  (void) offset;
+  throw FileAccessFailed("DirectFile::write", p_filename, "write");
+#endif
+}
+
+void DirectFile::printBandwidth(const char* operation) const {
+  std::cout << timestamp(current_duration()) << operation << " " << p_directBytes << " bytes of <" << p_filename
+            << "> with O_DIRECT in " << p_seconds << " s";
+  if (p_seconds > 0) {
+    std::cout << " (" << (p_directBytes + p_bufferedBytes) / p_seconds / 1e6 << " MB/s)";
+  }
+  if (p_bufferedBytes > 0) {
+    std::cout << ", " << p_bufferedBytes << " bytes of partial blocks through the page cache";
+  }
+  std::cout << ".\n";
+}
+
+DirectFile::~DirectFile() {
+#ifdef O_DIRECT
+  free(p_stage);
+  if (p_direct >= 0) {
+    close(p_direct);
+  }
+  if (p_buffered >= 0) {
+    close(p_buffered);
+  }
+#endif
+}
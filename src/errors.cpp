@@ -77,6 +77,18 @@ const char* CannotCreateFile::what() const noexcept {
   exit(-1);
 }
 
+FileAccessFailed::FileAccessFailed(std::string function, std::string filename, std::string operation)
+  : p_filename(filename), p_operation(operation) {
+  p_func = function;
+}
+
+const char* FileAccessFailed::what() const noexcept {
+  std::cout << timestamp(current_duration());
+  print_lightred("ERROR: ");
+  std::cout << "Couldn't " << p_operation << " file <" << p_filename << "> in function <" << p_func << ">.\n";
+  exit(-1);
+}
+
 NoKey::NoKey(std::string function, std::string filename) : p_filename(filename) {
   p_func = function;
 }
@@ -96,8 +108,10 @@ void syntax() {
   std::cout << EXECUTE << " <argument1> <argument2> ...\n";
   std::cout << "Valid options are:\n";
   syntaxCrypt();
+  syntaxBatch();
   syntaxGenerateKey();
   syntaxGenerateRotors();
+  syntaxBenchmark();
   syntaxHelp();
 }
 
@@ -108,7 +122,11 @@ void syntaxCrypt() {
   std::cout << "    key         : path and filename (without ending) of the key used to be "
                "encrypt/decrypt\n";
   std::cout << "    rotors      : path to the directory where the rotor files are stored\n";
+  std::cout << "                  or " << EMBEDDED_ROTORS << " for the rotors compiled into the binary\n";
   std::cout << "    output_file : path and filename (with ending) to write the file into\n";
+  std::cout << "    input_file and output_file may be " << PIPE_NAME
+            << " for stdin and stdout, then the format v3 is used and the log is\n";
+  std::cout << "    written to stderr\n";
   std::cout << "- " << EXECUTE << " <input_file>\n";
   std::cout << "    input_file  : path and filename (with ending) of the file to be encrypted\n";
   std::cout << "                  <key> is assumed to be default, which is <" << STD_KEY_DIR << STD_KEY << ">.\n";
@@ -122,6 +140,39 @@ void syntaxCrypt() {
   std::cout << "    input_file  : path and filename (with ending) of the file to be decrypted\n";
   std::cout << "                  <key> is assumed to be default, which is <" << STD_KEY_DIR << STD_KEY_INV << ">.\n";
   std::cout << "                  <output_file> is assumed to be <input_file> without the suffix <.tur>.\n";
+  std::cout << "  Options for all of these commands:\n";
+  std::cout << "    --checkpoint-interval=<n> : cache the rotor state every <n> bytes for later runs with the same\n";
+  std::cout << "                                key, 0 disables the cache (default). It contains key material!\n";
+  std::cout << "    --cache-size=<size>       : limit of the cache directory, e.g. 512K, 64M (default), 1G\n";
+  std::cout << "    --cache-dir=<directory>   : where the cache is stored, default is <" << STD_CACHE_DIR << ">\n";
+  std::cout << "    --format=<v1|v2|v3>       : file format written by encryption, v1 is the legacy format\n";
+  std::cout << "                                (default), v2 splits the file into independently encrypted chunks,\n";
+  std::cout << "                                v3 writes them in frames without knowing the size in advance.\n";
+  std::cout << "                                Decryption detects the format from the file header.\n";
+  std::cout << "    --chunk-size=<size>       : size of the chunks in format v2 and v3, default is 1M\n";
+  std::cout << "    --kernel=<name>           : instruction set to use: auto (default), generic, sse4, avx2\n";
+  std::cout << "                                or avx512\n";
+  std::cout << "    --mode=<mode>             : interleaved (default) or pipelined, where separate threads compute\n";
+  std::cout << "                                the rotor states ahead of the substitution\n";
+  std::cout << "    --ring-depth=<n>          : number of blocks buffered in the pipelined mode, default is "
+            << STD_RING_DEPTH << "\n";
+  std::cout << "    --block-size=<n>          : number of positions per block in the pipelined mode, default is "
+            << STD_BLOCK_SIZE << "\n";
+  std::cout << "    --threads=<n>             : number of threads sharing the work, default 0 uses all processors\n";
+  std::cout << "                                available according to affinity mask and cgroup cpu quota\n";
+  std::cout << "    --placement=<where>       : heap (default) or local, where the data is put on huge pages and the\n";
+  std::cout << "                                pinned threads fault in their own parts on their NUMA node\n";
+  std::cout << "    --memory=<bytes>          : processes the file in two alternating windows within this memory\n";
+  std::cout << "                                cap, so files larger than the memory can be handled, default 0\n";
+  std::cout << "                                reads the whole file at once\n";
+  std::cout << "    --io=<backend>            : stdio (default) or mmap, which transforms the mapped input directly\n";
+  std::cout << "                                into the mapped output, uring keeps several windows in flight on an\n";
+  std::cout << "                                io_uring and falls back to pread and pwrite without one\n";
+  std::cout << "    --in-place                : transforms a file of the legacy format within its own mapping and\n";
+  std::cout << "                                renames it to <outputfile>\n";
+  std::cout << "    --direct                  : streams the file with O_DIRECT past the page cache, the memory cap\n";
+  std::cout << "                                defaults to " << (STD_DIRECT_MEMORY >> 20)
+            << "M, prints the bandwidth achieved\n";
 }
 
 void syntaxGenerateKey() {
@@ -134,6 +185,8 @@ void syntaxGenerateKey() {
   std::cout << "    length      : length of the key, recommended to use length 8 or larger\n";
   std::cout << "                  Assumes <rotors> to be all rotors that can be found in <" << STD_ROT_DIR << ">.\n";
   std::cout << "                  If <" << STD_ROT_DIR << "> is empty generate all rotors with valid names in there.\n";
+  std::cout << "  Options for these commands:\n";
+  std::cout << "    --min-cycle=<n>           : reject initial rotor states whose states repeat within <n> rotations\n";
 }
 
 void syntaxGenerateRotors() {
@@ -150,12 +203,45 @@ void syntaxGenerateRotors() {
   std::cout << "                  generate all valid rotors with a random seed\n";
   std::cout << "- " << EXECUTE << " genRot -a <seed>\n";
   std::cout << "                  generate all valid rotors with given seed\n";
+  std::cout << "    the rotors are packed into <" << STD_ROT_DIR << ROTOR_BUNDLE << "> after generating them\n";
+  std::cout << "- " << EXECUTE << " bundle <rotors>\n";
+  std::cout << "    rotors      : directory whose rotor files are packed into <" << ROTOR_BUNDLE << ">, default is <"
+            << STD_ROT_DIR << ">\n";
+  std::cout << "                  crypt maps the bundle instead of opening every rotor file\n";
+  std::cout << "  Options for genRot:\n";
+  std::cout << "    --distinct-rotors         : every rotor gets its own permutation from the ChaCha stream of seed\n";
+  std::cout << "                                and name instead of all rotors sharing one, computed by --threads\n";
+}
+
+void syntaxBenchmark() {
+  std::cout << "- " << EXECUTE << " bench <states>\n";
+  std::cout << "    states      : number of independent rotor states stepped at once, default is " << STD_BENCH_STATES
+            << "\n";
+  std::cout << "                  prints the throughput of rotate, of the substitution and of ChaCha for all\n";
+  std::cout << "                  kernels supported by the processor\n";
+  std::cout << "- " << EXECUTE << " -t <iterations> <keys>\n";
+  std::cout << "    iterations  : maximal number of rotations checked for each key\n";
+  std::cout << "    keys        : one or more key files, they are tested in parallel\n";
+  std::cout << "                  prints tail and length of the cycle of the rotor states of each key\n";
+}
+
+void syntaxBatch() {
+  std::cout << "- " << EXECUTE << " batch <source> <key> <rotors> <output_directory>\n";
+  std::cout << "    source      : directory whose files are encrypted/decrypted recursively or a manifest\n";
+  std::cout << "                  listing one file per line\n";
+  std::cout << "    key         : path and filename (without ending) of the key used to be encrypt/decrypt\n";
+  std::cout << "    rotors      : path to the directory where the rotor files are stored\n";
+  std::cout << "                  or " << EMBEDDED_ROTORS << " for the rotors compiled into the binary\n";
+  std::cout << "    output_directory : where the outputs are written with their relative paths, encryption\n";
+  std::cout << "                  appends .tur, decryption removes it\n";
+  std::cout << "                  key and rotors are loaded once, the files share the threads and only the\n";
+  std::cout << "                  totals are printed. Accepts the options of crypt.\n";
 }
 
 void syntaxHelp() {
   std::cout << "- " << EXECUTE << " help <command>\n";
   std::cout << "    command     : command you want to see detailed information about\n";
-  std::cout << "                  options are: <crypt>, <genKey>, <genRot> and <help>\n";
+  std::cout << "                  options are: <crypt>, <batch>, <genKey>, <genRot>, <bench> and <help>\n";
 }
 
 /***********************************************************************************************************************
@@ -17,27 +17,997 @@
  */
 #include "fileinteraction.hpp"
 
-#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <stdio.h>
 #include <stdlib.h>
+#include <thread>
+#include <vector>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "buffer.hpp"
+#include "directfile.hpp"
 #include "errors.hpp"
+#include "ioring.hpp"
+#include "mappedfile.hpp"
 #include "measurement.hpp"
+#include "positionalfile.hpp"
+#include "rotorbundle.hpp"
+#include "rotorgenerate.hpp"
+#include "substitute.hpp"
 #include "turinga.hpp"
 
-#include <iostream>
+// pins the threads and lets each of them fault in the pages it will work on
+static void placeBytes(
+  Data& bytes, const TuringaKey& key, const CryptOptions& options, const FileHeader& header, const Pages pages) {
+  const double start  = current_duration();
+  const WorkPlan plan = planEncrypt(bytes.size, key, options, header);
+  size_t pinned       = 0;
+  if (plan.threads > 1) {
+    ThreadPool& pool = cryptPool(options);
+    pinned           = pool.pin();
+    pool.limit(plan.threads);
+    firstTouch(bytes, pool, plan.taskSize);
+  }
+  std::cout << timestamp(current_duration()) << "Allocated " << bytes.size << " bytes on " << pagesName(pages) << ", "
+            << pinned << " pinned threads faulted them in within " << current_duration() - start << " s.\n";
+}
 
-void handleCrypt(const char* filename, const char* outputfilename, const char* rotDirectory, TuringaKey key) {
-  Byte* rotors          = loadRotors(key, rotDirectory);
-  const size_t fileSize = file_size(filename);
-  Byte* data            = (Byte*) malloc(fileSize);
-  Data bytes{data, fileSize};
-  read_file(bytes, filename, key);
-  encrypt(bytes, key, rotors);
-  write_file(bytes, outputfilename, key);
+// writes magic, version, chunk size and original size of the chunked format
+static void encodeHeader(Byte* encoded, const FileHeader& header) {
+  const uint32_t version = header.version;
+  std::memcpy(encoded, FORMAT_MAGIC.c_str(), FORMAT_MAGIC.size());
+  std::memcpy(encoded + 4, &version, sizeof(uint32_t));
+  std::memcpy(encoded + 8, &header.chunkSize, sizeof(uint64_t));
+  std::memcpy(encoded + 16, &header.originalSize, sizeof(uint64_t));
+}
+
+// reads magic, version, chunk size and original size written by encodeHeader, false if the magic is missing
+static bool decodeHeader(const Byte* encoded, FileHeader& header) {
+  if (std::memcmp(encoded, FORMAT_MAGIC.c_str(), FORMAT_MAGIC.size()) != 0) {
+    return false;
+  }
+  uint32_t version;
+  std::memcpy(&version, encoded + 4, sizeof(uint32_t));
+  std::memcpy(&header.chunkSize, encoded + 8, sizeof(uint64_t));
+  std::memcpy(&header.originalSize, encoded + 16, sizeof(uint64_t));
+  header.version = static_cast<Format>(version);
+  return true;
+}
+
+/*!
+ * \struct Transfer
+ * \brief The struct Transfer describes a contiguous range copied between a window and a file.
+ */
+struct Transfer {
+  size_t position; /**< offset inside the window */
+  size_t length;   /**< number of bytes */
+  uint64_t offset; /**< offset inside the file */
+};
+
+// splits the positions [begin, begin + length) of the data into the ranges of a file, which holds the data rotated by
+// shift, i.e. position i of the data is found at (i + size - shift) % size of the file, returns the number of ranges
+static size_t rotatedTransfers(
+  Transfer* transfers, const size_t begin, const size_t length, const size_t size, const size_t shift) {
+  size_t count = 0;
+  // the positions in front of shift wrap around to the end of the file
+  const size_t split = std::clamp(shift, begin, begin + length);
+  if (split > begin) {
+    transfers[count++] = Transfer{0, split - begin, size - shift + begin};
+  }
+  if (begin + length > split) {
+    transfers[count++] = Transfer{split - begin, begin + length - split, split - shift};
+  }
+  return count;
+}
+
+// copies the positions [begin, begin + length) of the data between window and a file holding the data rotated by shift
+template <class File>
+static void transferRotated(
+  File& file, Byte* window, const size_t begin, const size_t length, const size_t size,
+  const size_t shift, const bool write) {
+  Transfer transfers[2];
+  const size_t count = rotatedTransfers(transfers, begin, length, size, shift);
+  for (size_t i = 0; i < count; ++i) {
+    if (write) {
+      file.write(window + transfers[i].position, transfers[i].length, transfers[i].offset);
+    }
+    else {
+      file.read(window + transfers[i].position, transfers[i].length, transfers[i].offset);
+    }
+  }
+}
+
+// number of positions per window, two windows have to fit into the memory cap
+static size_t windowSize(const CryptOptions& options, const FileHeader& header) {
+  size_t window = options.memory / 2;
+  // a cap beyond the file doesn't need a larger window, the size of a stream is unknown
+  if (header.originalSize > 0) {
+    window = std::min<size_t>(window, header.originalSize);
+  }
+  if (header.version == chunked && window >= header.chunkSize) {
+    // windows holding whole chunks don't need to advance the derived rotor states
+    window = window / header.chunkSize * header.chunkSize;
+  }
+  if (window == 0) {
+    throw InvalidArgument("windowSize", std::to_string(options.memory), "as memory cap");
+  }
+  return window;
+}
+
+/*!
+ * class IoThread
+ * \brief thread transferring windows beside the encryption of another window
+ * \details The thread runs two steps, the second one is skipped once the thread has been stopped. If the encryption
+ * throws, the destructor stops and joins the thread while the stack unwinds, so the buffers and files outlive it.
+ */
+class IoThread {
+private:
+  std::atomic<bool> p_stop;      /**< tells the thread to skip the second step */
+  std::exception_ptr p_failure;  /**< exception thrown by a step */
+  std::thread p_thread;          /**< the thread, started last */
+
+public:
+  IoThread(std::function<void()> first, std::function<void()> second)
+    : p_stop(false), p_thread([this, first = std::move(first), second = std::move(second)]() {
+        try {
+          first();
+          if (!p_stop.load()) {
+            second();
+          }
+        } catch (...) {
+          p_failure = std::current_exception();
+        }
+      }) {}
+
+  // waits for both steps and rethrows the exception of a failed one
+  void join() {
+    p_thread.join();
+    if (p_failure) {
+      std::rethrow_exception(p_failure);
+    }
+  }
+
+  ~IoThread() {
+    if (p_thread.joinable()) {
+      p_stop.store(true);
+      p_thread.join();
+    }
+  }
+};
+
+// encrypts/ decrypts window by window, while one window is processed the previous one is written and the next one is
+// read into the other buffer
+template <class File>
+static void streamWindows(
+  File& input, File& output, const TuringaKey& key, const Byte* rotors, const CryptOptions& options,
+  const FileHeader& header) {
+  const size_t size    = header.originalSize;
+  const size_t window  = windowSize(options, header);
+  const size_t windows = (size + window - 1) / window;
+  const size_t shift   = (size > 0) ? key.fileShift % size : 0;
+  const uint64_t skip  = (header.version == chunked) ? HEADER_SIZE : 0;  // header in front of the encrypted data
+
+  printCryptSetup(options);
+  std::cout << timestamp(current_duration()) << "Streaming " << windows << " windows of up to " << window
+            << " bytes within a memory cap of " << options.memory << " bytes.\n";
+
+  if (key.direction == encryption && header.version == chunked) {
+    Byte encoded[HEADER_SIZE];
+    encodeHeader(encoded, header);
+    output.write(encoded, HEADER_SIZE, 0);
+  }
+
+  // the plain data is stored rotated by shift, the encrypted data follows the header
+  const auto load = [&](Byte* buffer, const size_t k) {
+    const size_t begin = k * window;
+    if (key.direction == encryption) {
+      transferRotated(input, buffer, begin, std::min(window, size - begin), size, shift, false);
+    }
+    else {
+      input.read(buffer, std::min(window, size - begin), skip + begin);
+    }
+  };
+  const auto store = [&](Byte* buffer, const size_t k) {
+    const size_t begin = k * window;
+    if (key.direction == encryption) {
+      output.write(buffer, std::min(window, size - begin), skip + begin);
+    }
+    else {
+      transferRotated(output, buffer, begin, std::min(window, size - begin), size, shift, true);
+    }
+  };
+
+  Buffer buffers[2] = {Buffer(window, options.placement), Buffer(window, options.placement)};
+  for (size_t i = 0; i < 2 && options.placement == local; ++i) {
+    Data buffer{buffers[i].bytes(), window};
+    placeBytes(buffer, key, options, header, buffers[i].pages());
+  }
+  std::unique_ptr<CheckpointCache> cache;
+  if (header.version != chunked) {
+    cache = std::make_unique<CheckpointCache>(key.rotorShifts, options);
+  }
+
+  const double start = current_duration();
+  if (windows > 0) {
+    load(buffers[0].bytes(), 0);
+  }
+  for (size_t k = 0; k < windows; ++k) {
+    Byte* other = buffers[(k + 1) % 2].bytes();
+    IoThread io(
+      [&, k]() {
+        if (k > 0) {
+          store(other, k - 1);
+        }
+      },
+      [&, k]() {
+        if (k + 1 < windows) {
+          load(other, k + 1);
+        }
+      });
+    Data bytes{buffers[k % 2].bytes(), std::min(window, size - k * window)};
+    encryptWindow(bytes, k * window, key, rotors, options, header, cache.get());
+    io.join();
+  }
+  if (windows > 0) {
+    store(buffers[(windows - 1) % 2].bytes(), windows - 1);
+  }
+
+  if (cache) {
+    cache->save();
+    cache->printStats();
+  }
+  printThroughput(size, current_duration() - start);
+}
+
+// streams the file through two windows with pread and pwrite, with --direct the transfers bypass the page cache
+static void streamCrypt(
+  const char* filename, const char* outputfilename, const TuringaKey& key, const Byte* rotors,
+  const CryptOptions& options, const FileHeader& header) {
+  CryptOptions streaming = options;
+  if (streaming.memory == 0) {
+    streaming.memory = STD_DIRECT_MEMORY;
+  }
+  bool streamed = false;
+  if (options.direct) {
+    const size_t transfer = std::min(windowSize(streaming, header) + DIRECT_ALIGNMENT, MAX_DIRECT_TRANSFER);
+    DirectFile input(filename, false, transfer);
+    DirectFile output(outputfilename, true, transfer);
+    if (input.valid() && output.valid()) {
+      streamWindows(input, output, key, rotors, streaming, header);
+      input.printBandwidth("Read");
+      output.printBandwidth("Wrote");
+      streamed = true;
+    }
+    else {
+      const int error = input.valid() ? output.error() : input.error();
+      std::cout << timestamp(current_duration()) << "O_DIRECT is not available (" << std::strerror(error)
+                << "), falling back to the page cache.\n";
+    }
+  }
+  if (!streamed) {
+    PositionalFile input(filename, false);
+    PositionalFile output(outputfilename, true);
+    streamWindows(input, output, key, rotors, streaming, header);
+  }
+  if (key.direction == encryption) {
+    std::cout << timestamp(current_duration()) << "File has been encrypted and written to <" << outputfilename
+              << ">.\n";
+  }
+  else {
+    std::cout << timestamp(current_duration()) << "File has been decrypted and written to <" << outputfilename
+              << ">.\n";
+  }
+}
 
+// encrypts/ decrypts window by window like streamCrypt, but the reads and writes of several windows are in flight
+// with io_uring while the windows are transformed in order
+static void uringCrypt(
+  const char* filename, const char* outputfilename, const TuringaKey& key, const Byte* rotors,
+  const CryptOptions& options, const FileHeader& header) {
+  const size_t size    = header.originalSize;
+  const size_t window  = std::clamp<size_t>(
+    (options.memory != 0) ? options.memory / URING_WINDOWS : STD_URING_WINDOW, 1, MAX_URING_TRANSFER);
+  const size_t windows = (size + window - 1) / window;
+  const size_t slots   = std::clamp<size_t>(windows, 1, URING_WINDOWS);
+
+  // the buffers are declared before the ring, so its destructor waits for the requests in flight before they go
+  std::vector<Buffer> memory;
+  std::vector<Byte*> buffers(slots);
+  // every window is transferred in at most two requests
+  IoRing ring(2 * slots);
+  if (!ring.valid()) {
+    std::cout << timestamp(current_duration()) << "io_uring is not available (" << std::strerror(ring.error())
+              << "), falling back to pread and pwrite.\n";
+    CryptOptions fallback = options;
+    fallback.memory       = URING_WINDOWS * window;
+    streamCrypt(filename, outputfilename, key, rotors, fallback, header);
+    return;
+  }
+
+  const size_t shift  = (size > 0) ? key.fileShift % size : 0;
+  const uint64_t skip = (header.version == chunked) ? HEADER_SIZE : 0;  // header in front of the encrypted data
+  printCryptSetup(options);
+  PositionalFile input(filename, false);
+  PositionalFile output(outputfilename, true);
+  if (key.direction == encryption && header.version == chunked) {
+    Byte encoded[HEADER_SIZE];
+    encodeHeader(encoded, header);
+    output.write(encoded, HEADER_SIZE, 0);
+  }
+
+  memory.reserve(slots);
+  for (size_t i = 0; i < slots; ++i) {
+    buffers[i] = memory.emplace_back(window, options.placement).bytes();
+    if (options.placement == local) {
+      Data buffer{buffers[i], window};
+      placeBytes(buffer, key, options, header, memory[i].pages());
+    }
+  }
+  const bool fixed = ring.registerBuffers(buffers.data(), slots, window);
+  std::cout << timestamp(current_duration()) << "io_uring with " << slots << " windows of up to " << window
+            << " bytes in flight, " << (fixed ? "registered" : "unregistered") << " buffers.\n";
+  std::unique_ptr<CheckpointCache> cache;
+  if (header.version != chunked) {
+    cache = std::make_unique<CheckpointCache>(key.rotorShifts, options);
+  }
+
+  // slot i holds the windows i, i + slots, i + 2 * slots, ...
+  struct Slot {
+    size_t window;          /**< window currently held */
+    bool write;             /**< whether the window is being written */
+    bool loaded;            /**< whether the window has been read completely */
+    size_t pending;         /**< number of unfinished transfers */
+    Transfer transfers[2];  /**< ranges of the window in the file */
+  };
+  std::vector<Slot> state(slots);
+  size_t requests = 0, retries = 0;
+  const auto enqueue = [&](const size_t i, const size_t t) {
+    const Transfer& transfer = state[i].transfers[t];
+    const int descriptor     = state[i].write ? output.descriptor() : input.descriptor();
+    ring.prepare(
+      state[i].write, descriptor, buffers[i] + transfer.position, transfer.length, transfer.offset, i, 2 * i + t);
+    ++requests;
+  };
+  const auto start = [&](const size_t i, const size_t k, const bool write) {
+    Slot& slot         = state[i];
+    const size_t begin = k * window;
+    const size_t count = std::min(window, size - begin);
+    slot.window        = k;
+    slot.write         = write;
+    slot.loaded        = false;
+    // the plain data is stored rotated by shift, the encrypted data follows the header
+    if ((key.direction == encryption) != write) {
+      slot.pending = rotatedTransfers(slot.transfers, begin, count, size, shift);
+    }
+    else {
+      slot.transfers[0] = Transfer{0, count, skip + begin};
+      slot.pending      = 1;
+    }
+    for (size_t t = 0; t < slot.pending; ++t) {
+      enqueue(i, t);
+    }
+  };
+
+  const double begin = current_duration();
+  for (size_t i = 0; i < std::min(slots, windows); ++i) {
+    start(i, i, false);
+  }
+  size_t next = 0, written = 0;
+  while (written < windows) {
+    const size_t i   = next % slots;
+    const bool ready = next < windows && state[i].loaded && !state[i].write && state[i].window == next;
+    ring.submit(ready ? 0 : 1);
+
+    uint64_t userData;
+    int result;
+    while (ring.pop(userData, result)) {
+      Slot& slot         = state[userData / 2];
+      Transfer& transfer = slot.transfers[userData % 2];
+      if (result <= 0) {
+        throw FileAccessFailed(
+          "uringCrypt", slot.write ? outputfilename : filename, slot.write ? "write to" : "read from");
+      }
+      // short transfers are continued with the remaining bytes
+      if (static_cast<size_t>(result) < transfer.length) {
+        transfer.position += result;
+        transfer.length -= result;
+        transfer.offset += result;
+        enqueue(userData / 2, userData % 2);
+        ++retries;
+        continue;
+      }
+      if (--slot.pending > 0) {
+        continue;
+      }
+      if (!slot.write) {
+        slot.loaded = true;
+      }
+      else {
+        ++written;
+        if (slot.window + slots < windows) {
+          start(userData / 2, slot.window + slots, false);
+        }
+      }
+    }
+
+    if (ready) {
+      Data bytes{buffers[i], std::min(window, size - next * window)};
+      encryptWindow(bytes, next * window, key, rotors, options, header, cache.get());
+      start(i, next, true);
+      ++next;
+    }
+  }
+
+  if (cache) {
+    cache->save();
+    cache->printStats();
+  }
+  std::cout << timestamp(current_duration()) << requests << " requests submitted, " << retries
+            << " of them continued short transfers.\n";
+  printThroughput(size, current_duration() - begin);
+  std::cout << timestamp(current_duration()) << "File has been " << ((key.direction == encryption) ? "en" : "de")
+            << "crypted into <" << outputfilename << ">.\n";
+}
+
+// encrypts/ decrypts from the input mapping into the output mapping, every thread copies its range into the output
+// right before transforming it
+static void mappedCrypt(
+  const char* filename, const char* outputfilename, const TuringaKey& key, const Byte* rotors,
+  const CryptOptions& options, const FileHeader& header) {
+  const size_t size  = header.originalSize;
+  const size_t shift = (size > 0) ? key.fileShift % size : 0;
+  const size_t skip  = (header.version == chunked) ? HEADER_SIZE : 0;  // header in front of the encrypted data
+
+  printCryptSetup(options);
+  const MappedFile input(filename, readOnly);
+  const MappedFile output(outputfilename, create, (key.direction == encryption) ? skip + size : size);
+  std::cout << timestamp(current_duration()) << "Mapped " << input.size() << " bytes of <" << filename << "> and "
+            << output.size() << " bytes of <" << outputfilename << ">.\n";
+  if (key.direction == encryption && header.version == chunked) {
+    encodeHeader(output.bytes(), header);
+  }
+  std::unique_ptr<CheckpointCache> cache;
+  if (header.version != chunked) {
+    cache = std::make_unique<CheckpointCache>(key.rotorShifts, options);
+  }
+
+  // position i of the data is found at (i + size - shift) % size of the plain file, so the positions in front of
+  // shift and the others are contiguous in both files
+  const double start = current_duration();
+  const auto part    = [&](Byte* destination, const Byte* source, const size_t offset, const size_t length) {
+    if (length > 0) {
+      Data bytes{destination, length};
+      const RangeIO io{
+        [source](Byte* window, const size_t begin, const size_t end) {
+          std::memcpy(window + begin, source + begin, end - begin);
+        },
+        nullptr};
+      encryptWindow(bytes, offset, key, rotors, options, header, cache.get(), &io);
+    }
+  };
+  if (key.direction == encryption) {
+    part(output.bytes() + skip, input.bytes() + size - shift, 0, shift);
+    part(output.bytes() + skip + shift, input.bytes(), shift, size - shift);
+  }
+  else {
+    part(output.bytes() + size - shift, input.bytes() + skip, 0, shift);
+    part(output.bytes(), input.bytes() + skip + shift, shift, size - shift);
+  }
+
+  if (cache) {
+    cache->save();
+    cache->printStats();
+  }
+  printThroughput(size, current_duration() - start);
+  std::cout << timestamp(current_duration()) << "File has been " << ((key.direction == encryption) ? "en" : "de")
+            << "crypted into <" << outputfilename << ">.\n";
+}
+
+// encrypts/ decrypts a legacy file within its own mapping and renames it afterwards
+static void inPlaceCrypt(
+  const char* filename, const char* outputfilename, const TuringaKey& key, const Byte* rotors,
+  const CryptOptions& options, const FileHeader& header) {
+  if (header.version == chunked) {
+    throw InvalidArgument("inPlaceCrypt", "--in-place", "with the chunked format, which changes the file size");
+  }
+  printCryptSetup(options);
+  {
+    const MappedFile file(filename, readWrite);
+    const size_t size  = file.size();
+    const size_t shift = (size > 0) ? key.fileShift % size : 0;
+    std::cout << timestamp(current_duration()) << "Mapped " << size << " bytes of <" << filename << "> for in place "
+              << ((key.direction == encryption) ? "en" : "de") << "cryption.\n";
+
+    const double start = current_duration();
+    Data bytes{file.bytes(), size};
+    CheckpointCache cache(key.rotorShifts, options);
+    // position i of the data belongs to position (i + size - shift) % size of the plain file
+    if (key.direction == encryption) {
+      std::rotate(bytes.bytes, bytes.bytes + size - shift, bytes.bytes + size);
+    }
+    encryptWindow(bytes, 0, key, rotors, options, header, &cache);
+    if (key.direction == decryption) {
+      std::rotate(bytes.bytes, bytes.bytes + shift, bytes.bytes + size);
+    }
+    cache.save();
+    cache.printStats();
+    printThroughput(size, current_duration() - start);
+  }
+
+  if (std::strcmp(filename, outputfilename) != 0) {
+    std::error_code error;
+    std::filesystem::rename(filename, outputfilename, error);
+    if (error) {
+      throw FileAccessFailed("inPlaceCrypt", filename, "rename");
+    }
+  }
+  std::cout << timestamp(current_duration()) << "File has been " << ((key.direction == encryption) ? "en" : "de")
+            << "crypted in place and renamed to <" << outputfilename << ">.\n";
+}
+
+// preallocates the output and writes the header, then returns the transfers of the tasks between the files and the
+// data of header.originalSize bytes
+static RangeIO positionalTransfers(
+  PositionalFile& input, PositionalFile& output, const TuringaKey& key, const FileHeader& header) {
+  const size_t size   = header.originalSize;
+  const size_t shift  = (size > 0) ? key.fileShift % size : 0;
+  const uint64_t skip = (header.version == chunked) ? HEADER_SIZE : 0;  // header in front of the encrypted data
+
+  output.reserve((key.direction == encryption) ? skip + size : size);
+  if (key.direction == encryption && header.version == chunked) {
+    Byte encoded[HEADER_SIZE];
+    encodeHeader(encoded, header);
+    output.write(encoded, HEADER_SIZE, 0);
+  }
+
+  // the plain data is stored rotated by shift, the encrypted data follows the header
+  RangeIO io;
+  if (key.direction == encryption) {
+    io.load = [&input, size, shift](Byte* data, const size_t begin, const size_t end) {
+      transferRotated(input, data + begin, begin, end - begin, size, shift, false);
+    };
+    io.store = [&output, skip](Byte* data, const size_t begin, const size_t end) {
+      output.write(data + begin, end - begin, skip + begin);
+    };
+  }
+  else {
+    io.load = [&input, skip](Byte* data, const size_t begin, const size_t end) {
+      input.read(data + begin, end - begin, skip + begin);
+    };
+    io.store = [&output, size, shift](Byte* data, const size_t begin, const size_t end) {
+      transferRotated(output, data + begin, begin, end - begin, size, shift, true);
+    };
+  }
+  return io;
+}
+
+// every task reads its range from the input right before and writes it to the preallocated output right after the
+// transformation, so reading and writing happen in parallel instead of before and after the work
+static void positionalCrypt(
+  Data& bytes, const char* filename, const char* outputfilename, TuringaKey& key, const Byte* rotors,
+  const CryptOptions& options, const FileHeader& header) {
+  PositionalFile input(filename, false);
+  PositionalFile output(outputfilename, true);
+  const RangeIO io = positionalTransfers(input, output, key, header);
+  std::cout << timestamp(current_duration()) << "Reading <" << filename << "> and writing <" << outputfilename
+            << "> by the tasks at their own offsets.\n";
+  encrypt(bytes, key, rotors, options, header, &io);
+  std::cout << timestamp(current_duration()) << "File has been written to <" << outputfilename << ">.\n";
+}
+
+/*!
+ * \struct StreamCloser
+ * \brief The struct StreamCloser closes the files opened by pipeCrypt, but leaves stdin and stdout open.
+ */
+struct StreamCloser {
+  bool owned; /**< whether the file has been opened by fopen */
+
+  void operator()(FILE* file) const {
+    if (owned) {
+      fclose(file);
+    }
+  }
+};
+/** file closed when leaving its scope */
+using Stream = std::unique_ptr<FILE, StreamCloser>;
+
+// encrypts/ decrypts a stream of unknown size in the framed format, input and output are read and written in order, so
+// they may be pipes. While one window is processed the previous one is written and the next one is read.
+static void pipeCrypt(
+  const char* filename, const char* outputfilename, const TuringaKey& key, const Byte* rotors,
+  const CryptOptions& options) {
+  const bool fromPipe          = (filename == PIPE_NAME);
+  const bool toPipe            = (outputfilename == PIPE_NAME);
+  const std::string inputName  = fromPipe ? "stdin" : filename;
+  const std::string outputName = toPipe ? "stdout" : outputfilename;
+  const Stream inputStream(fromPipe ? stdin : fopen(filename, "rb"), StreamCloser{!fromPipe});
+  if (!inputStream) {
+    throw FileNotFound("pipeCrypt", filename);
+  }
+  const Stream outputStream(toPipe ? stdout : fopen(outputfilename, "wb"), StreamCloser{!toPipe});
+  if (!outputStream) {
+    throw CannotCreateFile("pipeCrypt", outputfilename);
+  }
+  FILE* input  = inputStream.get();
+  FILE* output = outputStream.get();
+#ifdef _WIN32
+  _setmode(_fileno(input), _O_BINARY);
+  _setmode(_fileno(output), _O_BINARY);
+#endif
+
+  FileHeader header{framed, options.chunkSize, 0};
+  Byte encoded[HEADER_SIZE];
+  if (key.direction == encryption) {
+    encodeHeader(encoded, header);
+    if (fwrite(encoded, 1, HEADER_SIZE, output) != HEADER_SIZE) {
+      throw FileAccessFailed("pipeCrypt", outputName, "write");
+    }
+  }
+  else if (
+    fread(encoded, 1, HEADER_SIZE, input) != HEADER_SIZE || !decodeHeader(encoded, header) || header.version != framed
+    || header.chunkSize == 0) {
+    throw InvalidArgument("pipeCrypt", inputName, "as input, it doesn't start with the header of the framed format");
+  }
+  // the frames hold the chunks of the chunked format without a fileShift
+  const FileHeader chunks{chunked, header.chunkSize, 0};
+  CryptOptions streaming = options;
+  if (streaming.memory == 0) {
+    streaming.memory = STD_PIPE_MEMORY;
+  }
+  const size_t window = windowSize(streaming, chunks);
+
+  printCryptSetup(options);
+  std::cout << timestamp(current_duration()) << "Streaming <" << inputName << "> to <" << outputName
+            << "> in windows of up to " << window << " bytes within a memory cap of " << streaming.memory
+            << " bytes.\n";
+
+  // fills buffer with the next data, less than a window only at the end of the stream
+  uint64_t remaining = 0;  // bytes left in the current frame
+  bool ended         = false;
+  const auto fill    = [&](Byte* buffer) {
+    size_t count = 0;
+    if (key.direction == encryption) {
+      count = fread(buffer, 1, window, input);
+      if (count < window && ferror(input)) {
+        throw FileAccessFailed("pipeCrypt", inputName, "read");
+      }
+      return count;
+    }
+    // the windows of the decryption don't need to match the frames of the encryption
+    while (count < window && !ended) {
+      if (remaining == 0) {
+        if (fread(&remaining, sizeof(uint64_t), 1, input) != 1) {
+          throw FileAccessFailed("pipeCrypt", inputName, "read the next frame of the truncated");
+        }
+        ended = (remaining == 0);
+        continue;
+      }
+      const size_t part = std::min<uint64_t>(remaining, window - count);
+      if (fread(buffer + count, 1, part, input) != part) {
+        throw FileAccessFailed("pipeCrypt", inputName, "read the frame of the truncated");
+      }
+      count += part;
+      remaining -= part;
+    }
+    return count;
+  };
+  const auto drain = [&](const Byte* buffer, const size_t length) {
+    const uint64_t frame = length;
+    // the empty frame marks the end of the stream
+    if (key.direction == encryption && length > 0 && fwrite(&frame, sizeof(uint64_t), 1, output) != 1) {
+      throw FileAccessFailed("pipeCrypt", outputName, "write");
+    }
+    if (fwrite(buffer, 1, length, output) != length) {
+      throw FileAccessFailed("pipeCrypt", outputName, "write");
+    }
+  };
+
+  Buffer buffers[2] = {Buffer(window, options.placement), Buffer(window, options.placement)};
+  for (size_t i = 0; i < 2 && options.placement == local; ++i) {
+    Data buffer{buffers[i].bytes(), window};
+    placeBytes(buffer, key, options, chunks, buffers[i].pages());
+  }
+
+  const double start = current_duration();
+  size_t lengths[2]  = {fill(buffers[0].bytes()), 0};
+  size_t position    = 0;
+  for (size_t k = 0;; ++k) {
+    Data bytes{buffers[k % 2].bytes(), lengths[k % 2]};
+    // the stream ends within this window
+    const bool last = (bytes.size < window);
+    Byte* other     = buffers[(k + 1) % 2].bytes();
+    IoThread io(
+      [&, k]() {
+        if (k > 0) {
+          drain(other, lengths[(k + 1) % 2]);
+        }
+      },
+      [&, k]() {
+        if (!last) {
+          lengths[(k + 1) % 2] = fill(other);
+        }
+      });
+    if (bytes.size > 0) {
+      encryptWindow(bytes, position, key, rotors, streaming, chunks, nullptr);
+    }
+    io.join();
+    position += bytes.size;
+    if (last) {
+      drain(bytes.bytes, bytes.size);
+      break;
+    }
+  }
+  const uint64_t end = 0;
+  if (key.direction == encryption && fwrite(&end, sizeof(uint64_t), 1, output) != 1) {
+    throw FileAccessFailed("pipeCrypt", outputName, "write");
+  }
+  if (fflush(output) != 0) {
+    throw FileAccessFailed("pipeCrypt", outputName, "write");
+  }
+
+  printThroughput(position, current_duration() - start);
+  std::cout << timestamp(current_duration()) << "Stream has been " << ((key.direction == encryption) ? "en" : "de")
+            << "crypted and written to <" << outputName << ">.\n";
+}
+
+// tells whether the output would overwrite the input, which the backends read while they write the output
+static bool sameFile(const char* filename, const char* outputfilename) {
+  std::error_code error;
+  return filename != PIPE_NAME && outputfilename != PIPE_NAME
+         && std::filesystem::equivalent(filename, outputfilename, error);
+}
+
+void handleCrypt(
+  const char* filename, const char* outputfilename, const char* rotDirectory, TuringaKey key,
+  const CryptOptions& options) {
+  Byte* rotors = loadRotors(key, rotDirectory);
+  // pipes have no size, they are always processed in the framed format
+  const bool piped = (filename == PIPE_NAME || outputfilename == PIPE_NAME);
+  FileHeader header{legacy, 0, piped ? 0 : file_size(filename)};
+  if (piped || (key.direction == encryption && options.format == framed)) {
+    header = FileHeader{framed, options.chunkSize, 0};
+  }
+  else if (key.direction == encryption && options.format == chunked) {
+    header = FileHeader{chunked, options.chunkSize, header.originalSize};
+  }
+  else if (key.direction == decryption) {
+    header = readHeader(filename);
+  }
+  if (header.version == framed && (options.inPlace || options.io != stdio || options.direct)) {
+    throw InvalidArgument("handleCrypt", "--io, --direct or --in-place", "together with the framed format");
+  }
+  if (options.direct && (options.inPlace || options.io != stdio)) {
+    throw InvalidArgument("handleCrypt", "--direct", "together with --in-place or another io backend than stdio");
+  }
+
+  // all backends but --in-place truncate the output before they have read the input, so the output of a file onto
+  // itself is written to a temporary file, which replaces the input at the end
+  const bool replace          = !options.inPlace && sameFile(filename, outputfilename);
+  const std::string target    = replace ? std::filesystem::canonical(outputfilename).string() : outputfilename;
+  const std::string temporary = target + ".tmp";
+  if (replace) {
+    std::cout << timestamp(current_duration()) << "Input and output are the same file, writing to <" << temporary
+              << "> first.\n";
+    outputfilename = temporary.c_str();
+  }
+
+  if (header.version == framed) {
+    pipeCrypt(filename, outputfilename, key, rotors, options);
+  }
+  else if (options.inPlace) {
+    inPlaceCrypt(filename, outputfilename, key, rotors, options, header);
+  }
+  else if (options.io == mapped) {
+    mappedCrypt(filename, outputfilename, key, rotors, options, header);
+  }
+  else if (options.io == uring) {
+    uringCrypt(filename, outputfilename, key, rotors, options, header);
+  }
+  else if (options.memory != 0 || options.direct) {
+    streamCrypt(filename, outputfilename, key, rotors, options, header);
+  }
+  else {
+    const Buffer memory(header.originalSize, options.placement);
+    Data bytes{memory.bytes(), header.originalSize};
+    if (options.placement == local) {
+      placeBytes(bytes, key, options, header, memory.pages());
+    }
+    positionalCrypt(bytes, filename, outputfilename, key, rotors, options, header);
+  }
+
+  if (replace) {
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error) {
+      throw FileAccessFailed("handleCrypt", temporary, "rename");
+    }
+    std::cout << timestamp(current_duration()) << "Replaced <" << target << "> by <" << temporary << ">.\n";
+  }
   free(rotors);
+  freeTuringaKey(key);
+}
+
+/*!
+ * \struct BatchFile
+ * \brief The struct BatchFile describes one file of a batch.
+ */
+struct BatchFile {
+  std::string input;  /**< name of the file to be encrypted/ decrypted */
+  std::string output; /**< name of the file to be written */
+  size_t size;        /**< size of the input file in bytes */
+};
+
+// name of the output of a batch, encryption appends .tur and decryption removes it
+static std::filesystem::path batchOutput(std::filesystem::path output, const TuringaKey& key) {
+  if (key.direction == encryption) {
+    output += ".tur";
+  }
+  else if (output.extension() == ".tur") {
+    output.replace_extension();
+  }
+  return output;
+}
+
+// lists the files below a directory or the files named line by line in a manifest, the outputs keep their relative
+// paths below outputDirectory, whose subdirectories are created on the way
+static std::vector<BatchFile> collectBatch(
+  const char* source, const std::filesystem::path& outputDirectory, const TuringaKey& key) {
+  std::vector<BatchFile> files;
+  std::filesystem::path created;
+  const auto add = [&](const std::filesystem::path& input, const std::filesystem::path& relative, size_t size) {
+    const std::filesystem::path output = batchOutput(outputDirectory / relative, key);
+    std::error_code error;
+    if (output.parent_path() != created) {
+      std::filesystem::create_directories(output.parent_path(), error);
+      created = output.parent_path();
+    }
+    if (std::filesystem::equivalent(input, output, error)) {
+      throw InvalidArgument("handleBatch", output.string(), "as output, it is the input file itself");
+    }
+    files.push_back(BatchFile{input.string(), output.string(), size});
+  };
+
+  if (std::filesystem::is_directory(source)) {
+    for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(source)) {
+      if (entry.is_regular_file()) {
+        add(entry.path(), entry.path().lexically_relative(source), entry.file_size());
+      }
+    }
+    return files;
+  }
+  std::ifstream manifest(source);
+  if (!manifest) {
+    throw FileNotFound("handleBatch", source);
+  }
+  std::string line;
+  while (std::getline(manifest, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
+    const std::filesystem::path input(line);
+    if (!std::filesystem::is_regular_file(input)) {
+      throw FileNotFound("handleBatch", line);
+    }
+    // parent directories of the input are dropped, so no output ends up outside of outputDirectory
+    std::filesystem::path relative;
+    for (const std::filesystem::path& part : input.lexically_normal().relative_path()) {
+      if (part != "..") {
+        relative /= part;
+      }
+    }
+    add(input, relative, std::filesystem::file_size(input));
+  }
+  return files;
+}
+
+// encrypts/ decrypts one file of a batch without printing anything, the tasks read and write their own ranges
+static void batchCrypt(
+  const BatchFile& file, const TuringaKey& key, const Byte* rotors, const CryptOptions& options,
+  CheckpointCache* cache) {
+  FileHeader header{legacy, 0, file.size};
+  if (key.direction == encryption && options.format == chunked) {
+    header = FileHeader{chunked, options.chunkSize, file.size};
+  }
+  else if (key.direction == decryption) {
+    header = readHeader(file.input.c_str(), false);
+    if (header.version == framed) {
+      throw InvalidArgument("handleBatch", file.input, "in a batch, framed streams are decrypted by crypt");
+    }
+  }
+  std::unique_ptr<CheckpointCache> ownCache;
+  if (header.version == legacy && cache == nullptr) {
+    ownCache = std::make_unique<CheckpointCache>(key.rotorShifts, options);
+    cache    = ownCache.get();
+  }
+
+  PositionalFile input(file.input.c_str(), false);
+  PositionalFile output(file.output.c_str(), true);
+  const RangeIO io = positionalTransfers(input, output, key, header);
+  Data bytes{(Byte*) malloc(header.originalSize), header.originalSize};
+  encryptWindow(bytes, 0, key, rotors, options, header, cache, &io);
   free(bytes.bytes);
+}
+
+void handleBatch(
+  const char* source, const char* outputDirectory, const char* rotDirectory, TuringaKey key,
+  const CryptOptions& options) {
+  if (key.direction == encryption && options.format == framed) {
+    throw InvalidArgument("handleBatch", "--format=v3", "in a batch, pipes are processed by crypt");
+  }
+  Byte* rotors                       = loadRotors(key, rotDirectory);
+  const std::vector<BatchFile> files = collectBatch(source, outputDirectory, key);
+  size_t total                       = 0;
+  for (const BatchFile& file : files) {
+    total += file.size;
+  }
+  printCryptSetup(options);
+  std::cout << timestamp(current_duration()) << "Found " << files.size() << " files with " << total
+            << " bytes in <" << source << ">.\n";
+
+  // files which would take longer than a balanced task of one thread are split between the threads
+  ThreadPool& pool         = cryptPool(options);
+  const size_t share       = std::max(FAST_PATH_BYTES, total / (pool.size() * TASKS_PER_THREAD));
+  CryptOptions whole       = options;
+  whole.threads            = 1;
+  whole.checkpointInterval = 0;
+
+  const double start = current_duration();
+  CheckpointCache cache(key.rotorShifts, options);
+  size_t split = 0;
+  for (const BatchFile& file : files) {
+    if (file.size > share) {
+      batchCrypt(file, key, rotors, options, &cache);
+      ++split;
+    }
+  }
+  // the small files are grouped into tasks of about share bytes, every file is processed whole by one thread
+  pool.limit(pool.size());
+  size_t first  = 0;
+  size_t weight = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (files[i].size <= share) {
+      weight += files[i].size + BATCH_FILE_COST;
+    }
+    if (weight >= share || i + 1 == files.size()) {
+      pool.submit([&files, &key, rotors, &whole, share, first, i]() {
+        for (size_t j = first; j <= i; ++j) {
+          if (files[j].size <= share) {
+            batchCrypt(files[j], key, rotors, whole, nullptr);
+          }
+        }
+      });
+      first  = i + 1;
+      weight = 0;
+    }
+  }
+  pool.wait();
+  const double duration = current_duration() - start;
+
+  cache.save();
+  pool.printStats();
+  std::cout << timestamp(current_duration()) << "Processed " << files.size() << " files with " << total
+            << " bytes in " << duration << " s";
+  if (duration > 0) {
+    std::cout << " (" << files.size() / duration << " files/s, " << total / duration / 1e6 << " MB/s)";
+  }
+  std::cout << ", " << split << " large files have been split between the threads.\n";
+  free(rotors);
   freeTuringaKey(key);
 }
 
@@ -55,58 +1025,52 @@ bool testForExistence(const char* filename) {
 }
 
 std::string findRotors(std::string path) {
+  if (path == EMBEDDED_ROTORS) {
+    return embeddedRotorNames();
+  }
+  // rotors added as files after the bundle was written are found as well
+  std::string available        = findRotorFiles(path);
+  const std::string bundleName = (std::filesystem::path(path) / ROTOR_BUNDLE).string();
+  if (testForExistence(bundleName.c_str())) {
+    available += RotorBundle(bundleName).names();
+  }
   std::string rotorsFound = "";
-  path += "rotor_";
-  for (unsigned int i = 0; i < VALID_ROT_NAMES.size(); ++i) {
-    std::string filename = path + VALID_ROT_NAMES[i];
-    if (!testForExistence(filename.c_str())) {
-      continue;
-    }
-    filename += "_reverse";
-    if (!testForExistence(filename.c_str())) {
-      continue;
+  for (const char name : VALID_ROT_NAMES) {
+    if (available.find(name) != std::string::npos) {
+      rotorsFound += name;
     }
-    rotorsFound += VALID_ROT_NAMES[i];
   }
   return rotorsFound;
 }
 
-void read_file(Data& bytes, const char* filename, const TuringaKey& key) {
+FileHeader readHeader(const char* filename, const bool verbose) {
+  const size_t fileSize = file_size(filename);
+  FileHeader header{legacy, 0, fileSize};
   FILE* myfile = fopen(filename, "rb");
   if (!myfile) {
-    throw FileNotFound("read_file", filename);
+    throw FileNotFound("readHeader", filename);
   }
 
-  size_t size = 0;
-  if (key.direction == encryption) {
-    int position = key.fileShift % bytes.size;
-    size += fread(bytes.bytes + position, 1, bytes.size - position, myfile) * sizeof(Byte);
-    size += fread(bytes.bytes, 1, position, myfile) * sizeof(Byte);
-  }
-  else {
-    size = fread(bytes.bytes, 1, bytes.size, myfile) * sizeof(Byte);
-  }
+  Byte encoded[HEADER_SIZE];
+  const size_t size = fread(encoded, 1, HEADER_SIZE, myfile);
   fclose(myfile);
-  assert(size == bytes.size && "Incomplete read of file!");
-  (void) size;
-  std::cout << timestamp(current_duration()) << "File has been read from <" << filename << ">.\n";
-}
 
-void write_file(const Data& bytes, const char* filename, const TuringaKey& key) {
-  FILE* myfile = fopen(filename, "wb");
-  if (!myfile) {
-    throw CannotCreateFile("write_file", filename);
+  FileHeader decoded;
+  if (size != HEADER_SIZE || !decodeHeader(encoded, decoded) || decoded.chunkSize == 0) {
+    return header;
   }
-  if (key.direction == encryption) {
-    fwrite(bytes.bytes, 1, bytes.size, myfile);
+  if (decoded.version == chunked && decoded.originalSize == fileSize - HEADER_SIZE) {
+    header = decoded;
   }
-  else {
-    int position = key.fileShift % bytes.size;
-    fwrite(bytes.bytes + position, 1, bytes.size - position, myfile);
-    fwrite(bytes.bytes, 1, position, myfile);
+  else if (decoded.version == framed && decoded.originalSize == 0) {
+    header = decoded;
   }
-  fclose(myfile);
-  std::cout << timestamp(current_duration()) << "File has been written to <" << filename << ">.\n";
+  if (verbose && header.version != legacy) {
+    std::cout << timestamp(current_duration()) << "Detected "
+              << ((header.version == chunked) ? "chunked file" : "framed stream") << " format with chunk size "
+              << header.chunkSize << ".\n";
+  }
+  return header;
 }
 
 // read the Turinga key
@@ -121,6 +1085,11 @@ TuringaKey readTuringaKey(const char* filename) {
   size += fread(&init, sizeof(Byte), 1, myfile) * sizeof(Byte);
   Byte dir       = init & 0b10000000;
   Byte keylength = init & 0b01111111;
+  if (size == 0 || keylength == 0 || keylength > MAX_KEYLENGTH) {
+    fclose(myfile);
+    throw InvalidArgument("readTuringaKey", filename,
+                          "as key file, its key length has to be between 1 and " + std::to_string(MAX_KEYLENGTH));
+  }
 
   Direction direction = (dir == 0) ? encryption : decryption;
 
@@ -133,10 +1102,14 @@ TuringaKey readTuringaKey(const char* filename) {
   Byte* rotorShifts = (Byte*) malloc(MAX_KEYLENGTH);
   size += fread(rotorShifts, sizeof(Byte), MAX_KEYLENGTH, myfile) * sizeof(Byte);
 
-  readKeyWarning(size, 1 + MAX_KEYLENGTH + sizeof(size_t) + (unsigned int) keylength);
+  // older keys end without the fingerprint of their rotor set
+  uint64_t rotorHash    = 0;
+  const size_t hashSize = fread(&rotorHash, 1, sizeof(uint64_t), myfile);
+  size += hashSize;
+  readKeyWarning(size, 1 + MAX_KEYLENGTH + sizeof(size_t) + (unsigned int) keylength + (hashSize > 0 ? 8 : 0));
 
   fclose(myfile);
-  const TuringaKey key{direction, keylength, rotorNames, rotorShifts, fileShift};
+  const TuringaKey key{direction, keylength, rotorNames, rotorShifts, fileShift, rotorHash};
   std::cout << timestamp(current_duration()) << "Turinga key has been read.\n";
   return key;
 }
@@ -152,42 +1125,115 @@ void writeTuringaKey(const std::string filename, const TuringaKey& key) {
   fwrite(key.rotorNames, sizeof(char), key.length, myfile);
   fwrite(&key.fileShift, sizeof(size_t), 1, myfile);
   fwrite(key.rotorShifts, sizeof(Byte), MAX_KEYLENGTH, myfile);
+  if (key.rotorHash != 0) {
+    fwrite(&key.rotorHash, sizeof(uint64_t), 1, myfile);
+  }
   fclose(myfile);
   std::cout << timestamp(current_duration()) << "Turinga key has been written to <" << filename << ">.\n";
 }
 
 Byte* loadRotors(const TuringaKey& key, const char* rotDirectory) {
-  std::string prefix(rotDirectory);
-  prefix += "/rotor_";
-  std::string suffix, filename;
-  if (key.direction == 0) {
-    suffix = "";
+  // the embedded rotors need no I/O at all, the bundle replaces two syscalls per rotor by one mapping and rotors
+  // missing in it are read from their files
+  const bool embedded = (rotDirectory == EMBEDDED_ROTORS);
+  if (embedded && embeddedRotorNames().empty()) {
+    throw InvalidArgument("loadRotors", rotDirectory, "as rotor directory, this binary has no embedded rotors");
   }
-  else if (key.direction == 1) {
-    suffix = "_reverse";
+  std::unique_ptr<RotorBundle> bundle;
+  const std::string bundleName = (std::filesystem::path(rotDirectory) / ROTOR_BUNDLE).string();
+  std::filesystem::file_time_type bundleTime;
+  if (!embedded && testForExistence(bundleName.c_str())) {
+    bundle     = std::make_unique<RotorBundle>(bundleName);
+    bundleTime = std::filesystem::last_write_time(bundleName);
   }
+  const std::string suffix = (key.direction == decryption) ? "_reverse" : "";
 
-  Byte* wheels = (Byte*) malloc(256 * key.length);
+  // every rotor is looked up once, repetitions in the key are copied from its first position
+  Byte* wheels = (Byte*) malloc(ROTOR_MEMORY);
+  int first[256];
+  std::fill(first, first + 256, -1);
+  size_t distinct = 0, fromFiles = 0;
   for (size_t i = 0; i < key.length; ++i) {
-    if (key.direction == encryption) {
-      filename = prefix + key.rotorNames[i] + suffix;
+    const char name  = (key.direction == encryption) ? key.rotorNames[i] : key.rotorNames[key.length - 1 - i];
+    Byte* wheel      = wheels + 256 * i;
+    const Byte index = static_cast<Byte>(name);
+    if (first[index] >= 0) {
+      std::memcpy(wheel, wheels + 256 * first[index], 256);
+      continue;
+    }
+    first[index] = i;
+    ++distinct;
+    const std::string filename = std::string(rotDirectory) + "/rotor_" + name + suffix;
+    const Byte* table          = embedded ? embeddedRotor(name, key.direction)
+                                 : bundle ? bundle->table(name, key.direction)
+                                          : nullptr;
+    // a rotor file edited after the bundle was written wins over the stale table in the bundle
+    std::error_code error;
+    if (bundle && table && std::filesystem::last_write_time(filename, error) > bundleTime && !error) {
+      std::cout << timestamp(current_duration()) << "<" << filename << "> is newer than <" << bundleName
+                << ">, the file is used.\n";
+      table = nullptr;
     }
-    else if (key.direction == decryption) {
-      filename = prefix + key.rotorNames[key.length - 1 - i] + suffix;
+    if (table) {
+      std::memcpy(wheel, table, 256);
+      continue;
+    }
+    if (embedded) {
+      throw InvalidArgument("loadRotors", std::string(1, name), "as name of an embedded rotor");
     }
-    const char* new_filename = filename.c_str();
-    FILE* myfile             = fopen(new_filename, "rb");
+    FILE* myfile               = fopen(filename.c_str(), "rb");
     if (!myfile) {
-      throw FileNotFound("loadRotors", new_filename);
+      throw FileNotFound("loadRotors", filename);
     }
-
-    size_t size = fread(wheels + 256 * i, 1, 256, myfile);
-    assert(size == 256 && "Rotors must have size 256!");
-    (void) size;
-
+    const size_t size = fread(wheel, 1, 256, myfile);
     fclose(myfile);
+    if (size != 256) {
+      throw FileAccessFailed("loadRotors", filename, "read 256 bytes of");
+    }
+    ++fromFiles;
   }
 
-  std::cout << timestamp(current_duration()) << "Rotors have been loaded.\n";
+  // the fingerprint identifies the rotor set of the key, it is the same on every machine with the same rotors
+  const uint64_t rotorHash = rotorSetHash(key, wheels);
+  std::cout << timestamp(current_duration()) << "Rotors have been loaded: " << distinct << " distinct of "
+            << key.length << ", " << distinct - fromFiles << (embedded ? " embedded, " : " from the bundle, ")
+            << fromFiles << " from files, fingerprint " << std::hex << std::setw(16) << std::setfill('0') << rotorHash
+            << std::dec << std::setfill(' ') << ".\n";
+  if (key.rotorHash != 0 && key.rotorHash != rotorHash) {
+    free(wheels);
+    throw InvalidArgument("loadRotors", rotDirectory, "as rotor directory, its rotors differ from the ones of the key");
+  }
+  deriveRotorTables(wheels, key.length);
   return wheels;
 }
+
+uint64_t rotorSetHash(const TuringaKey& key, const Byte* rotors) {
+  // the permutations in the order of the key, the rotors of a decryption key are inverted and reversed
+  std::vector<Byte> permutations(256 * key.length);
+  for (size_t i = 0; i < key.length; ++i) {
+    Byte* permutation = permutations.data() + 256 * i;
+    if (key.direction == encryption) {
+      std::memcpy(permutation, rotors + 256 * i, 256);
+      continue;
+    }
+    const Byte* inverse = rotors + 256 * (key.length - 1 - i);
+    for (size_t x = 0; x < 256; ++x) {
+      permutation[inverse[x]] = x;
+    }
+  }
+  return fingerprint(permutations.data(), permutations.size());
+}
+
+void stampRotorHash(TuringaKey& key, const char* rotDirectory) {
+  const std::string available = findRotors(rotDirectory);
+  for (size_t i = 0; i < key.length; ++i) {
+    if (available.find(key.rotorNames[i]) == std::string::npos) {
+      std::cout << timestamp(current_duration()) << "Rotor " << key.rotorNames[i] << " is missing in <"
+                << rotDirectory << ">, the key won't check its rotors.\n";
+      return;
+    }
+  }
+  Byte* rotors  = loadRotors(key, rotDirectory);
+  key.rotorHash = rotorSetHash(key, rotors);
+  free(rotors);
+}
@@ -0,0 +1,232 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ioring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "errors.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define IORING_AVAILABLE
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifdef IORING_AVAILABLE
+// address inside a ring mapping
+template<typename T>
+static T* at(void* mapping, const unsigned offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(mapping) + offset);
+}
+#endif
+
+IoRing::IoRing(const unsigned entries) :
+  p_descriptor(-1), p_error(ENOSYS), p_fixed(false), p_sqRing(nullptr), p_cqRing(nullptr), p_sqes(nullptr),
+  p_sqRingSize(0), p_cqRingSize(0), p_sqesSize(0), p_localTail(0), p_unsubmitted(0), p_inFlight(0) {
+#ifdef IORING_AVAILABLE
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  const int descriptor = syscall(__NR_io_uring_setup, entries, &params);
+  if (descriptor < 0) {
+    p_error = errno;
+    return;
+  }
+
+  // older kernels need separate mappings of the two rings
+  p_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  p_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    p_sqRingSize = p_cqRingSize = std::max(p_sqRingSize, p_cqRingSize);
+  }
+  p_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  p_sqRing   = mmap(
+    nullptr, p_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQ_RING);
+  p_cqRing = (params.features & IORING_FEAT_SINGLE_MMAP)
+               ? p_sqRing
+               : mmap(
+                 nullptr, p_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor,
+                 IORING_OFF_CQ_RING);
+  p_sqes =
+    mmap(nullptr, p_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES);
+  if (p_sqRing == MAP_FAILED || p_cqRing == MAP_FAILED || p_sqes == MAP_FAILED) {
+    p_error      = errno;
+    p_descriptor = descriptor;
+    release();
+    return;
+  }
+
+  p_sqTail     = at<unsigned>(p_sqRing, params.sq_off.tail);
+  p_sqMask     = at<unsigned>(p_sqRing, params.sq_off.ring_mask);
+  p_sqArray    = at<unsigned>(p_sqRing, params.sq_off.array);
+  p_cqHead     = at<unsigned>(p_cqRing, params.cq_off.head);
+  p_cqTail     = at<unsigned>(p_cqRing, params.cq_off.tail);
+  p_cqMask     = at<unsigned>(p_cqRing, params.cq_off.ring_mask);
+  p_cqes       = at<void>(p_cqRing, params.cq_off.cqes);
+  p_localTail  = *p_sqTail;
+  p_descriptor = descriptor;
+  p_error      = 0;
+#else
+  (void) entries;
+#endif
+}
+
+bool IoRing::registerBuffers(Byte* const* buffers, const unsigned count, const size_t size) {
+#ifdef IORING_AVAILABLE
+  std::vector<iovec> vectors(count);
+  for (unsigned i = 0; i < count; ++i) {
+    vectors[i] = iovec{buffers[i], size};
+  }
+  p_fixed = syscall(__NR_io_uring_register, p_descriptor, IORING_REGISTER_BUFFERS, vectors.data(), count) == 0;
+#else
+  (void) buffers;
+  (void) count;
+  (void) size;
+#endif
+  return p_fixed;
+}
+
+void IoRing::prepare(
+  const bool write, const int descriptor, Byte* bytes, const unsigned length, const uint64_t offset,
+  const unsigned index, const uint64_t userData) {
+#ifdef IORING_AVAILABLE
+  const unsigned slot = p_localTail & *p_sqMask;
+  io_uring_sqe& sqe   = static_cast<io_uring_sqe*>(p_sqes)[slot];
+  std::memset(&sqe, 0, sizeof(sqe));
+  if (p_fixed) {
+    sqe.opcode    = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+    sqe.buf_index = index;
+  }
+  else {
+    sqe.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+  }
+  sqe.fd            = descriptor;
+  sqe.addr          = reinterpret_cast<uint64_t>(bytes);
+  sqe.len           = length;
+  sqe.off           = offset;
+  sqe.user_data     = userData;
+  p_sqArray[slot]   = slot;
+  ++p_localTail;
+  ++p_unsubmitted;
+#else
+  (void) write;
+  (void) descriptor;
+  (void) bytes;
+  (void) length;
+  (void) offset;
+  (void) index;
+  (void) userData;
+#endif
+}
+
+void IoRing::submit(const unsigned wait) {
+#ifdef IORING_AVAILABLE
+  // the kernel must see the entries before the new tail
+  __atomic_store_n(p_sqTail, p_localTail, __ATOMIC_RELEASE);
+  const unsigned flags = (wait > 0) ? IORING_ENTER_GETEVENTS : 0;
+  // the kernel may consume fewer entries than passed and then doesn't wait, so the rest is passed again
+  while (true) {
+    const long consumed = syscall(__NR_io_uring_enter, p_descriptor, p_unsubmitted, wait, flags, nullptr, 0);
+    if (consumed < 0) {
+      if (errno != EINTR && errno != EAGAIN) {
+        throw FileAccessFailed("IoRing::submit", "io_uring", "submit requests to");
+      }
+      continue;
+    }
+    if (consumed == 0 && p_unsubmitted > 0) {
+      throw FileAccessFailed("IoRing::submit", "io_uring", "submit requests to");
+    }
+    p_unsubmitted -= consumed;
+    p_inFlight += consumed;
+    if (p_unsubmitted == 0) {
+      break;
+    }
+  }
+#else
+  (void) wait;
+#endif
+}
+
+bool IoRing::pop(uint64_t& userData, int& result) {
+#ifdef IORING_AVAILABLE
+  const unsigned head = *p_cqHead;
+  if (head == __atomic_load_n(p_cqTail, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  const io_uring_cqe& cqe = static_cast<io_uring_cqe*>(p_cqes)[head & *p_cqMask];
+  userData                = cqe.user_data;
+  result                  = cqe.res;
+  __atomic_store_n(p_cqHead, head + 1, __ATOMIC_RELEASE);
+  --p_inFlight;
+  return true;
+#else
+  (void) userData;
+  (void) result;
+  return false;
+#endif
+}
+
+void IoRing::release() noexcept {
+#ifdef IORING_AVAILABLE
+  if (p_sqes != nullptr && p_sqes != MAP_FAILED) {
+    munmap(p_sqes, p_sqesSize);
+  }
+  if (p_cqRing != nullptr && p_cqRing != MAP_FAILED && p_cqRing != p_sqRing) {
+    munmap(p_cqRing, p_cqRingSize);
+  }
+  if (p_sqRing != nullptr && p_sqRing != MAP_FAILED) {
+    munmap(p_sqRing, p_sqRingSize);
+  }
+  if (p_descriptor >= 0) {
+    close(p_descriptor);
+  }
+  p_sqes       = nullptr;
+  p_cqRing     = nullptr;
+  p_sqRing     = nullptr;
+  p_descriptor = -1;
+#endif
+}
+
+void IoRing::drain() noexcept {
+#ifdef IORING_AVAILABLE
+  uint64_t userData;
+  int result;
+  while (p_inFlight > 0) {
+    while (pop(userData, result)) {}
+    if (p_inFlight == 0) {
+      break;
+    }
+    if (syscall(__NR_io_uring_enter, p_descriptor, 0, p_inFlight, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+        && errno != EINTR && errno != EAGAIN) {
+      break;
+    }
+  }
+#endif
+}
+
+IoRing::~IoRing() {
+  if (p_descriptor >= 0) {
+    drain();
+  }
+  release();
+}
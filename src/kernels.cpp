@@ -0,0 +1,95 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "kernels.hpp"
+
+#include "chacha.hpp"
+#include "errors.hpp"
+#include "rotate.hpp"
+#include "substitute.hpp"
+
+static KernelTable kernelTable(const Kernel kernel) {
+  return KernelTable{kernel,
+                     rotateVariant(kernel),
+                     substituteVariant(kernel),
+                     rotateNVariant(kernel),
+                     advanceVariant(kernel),
+                     scheduleVariant(kernel),
+                     scheduledVariant(kernel),
+                     chachaVariant(kernel)};
+}
+
+KernelTable KERNELS = kernelTable(bestKernel());
+
+bool kernelSupported(const Kernel kernel) noexcept {
+#if defined(KERNEL_X86)
+  __builtin_cpu_init();  // needed since this may be called before main
+  switch (kernel) {
+  case avx512:
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+           && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512vbmi");
+  case avx2:
+    return __builtin_cpu_supports("avx2");
+  case sse4:
+    return __builtin_cpu_supports("sse4.1");
+  default:
+    return true;
+  }
+#else
+  return kernel == generic;
+#endif
+}
+
+Kernel bestKernel() noexcept {
+  for (const Kernel kernel : {avx512, avx2, sse4}) {
+    if (kernelSupported(kernel)) {
+      return kernel;
+    }
+  }
+  return generic;
+}
+
+std::string kernelName(const Kernel kernel) noexcept {
+  switch (kernel) {
+  case avx512:
+    return "avx512";
+  case avx2:
+    return "avx2";
+  case sse4:
+    return "sse4";
+  default:
+    return "generic";
+  }
+}
+
+void selectKernel(const std::string& name) {
+  if (name == "auto") {
+    KERNELS = kernelTable(bestKernel());
+    return;
+  }
+  for (const Kernel kernel : {generic, sse4, avx2, avx512}) {
+    if (name != kernelName(kernel)) {
+      continue;
+    }
+    if (!kernelSupported(kernel)) {
+      throw InvalidArgument("selectKernel", name, "as kernel, the processor doesn't support it");
+    }
+    KERNELS = kernelTable(kernel);
+    return;
+  }
+  throw InvalidArgument("selectKernel", name, "as kernel. Valid options are auto, generic, sse4, avx2 and avx512");
+}
@@ -19,14 +19,19 @@
 #include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <vector>
 
 #include <csprng.hpp>
 
+#include "benchmark.hpp"
 #include "chacha.hpp"
 #include "colors.hpp"
 #include "errors.hpp"
 #include "fileinteraction.hpp"
+#include "kernels.hpp"
 #include "measurement.hpp"
+#include "options.hpp"
+#include "rotorbundle.hpp"
 #include "rotorgenerate.hpp"
 #include "turinga.hpp"
 #include "types.hpp"
@@ -36,6 +41,8 @@
 int main(int argc, char** argv) {
   start_time();
   try {
+    const CryptOptions options = extractOptions(argc, argv);
+    selectKernel(options.kernel);
     if (argc < 2) {
       throw InappropriateNumberOfArguments("main", 2, argc);
     }
@@ -47,12 +54,18 @@ int main(int argc, char** argv) {
       else if (std::strcmp(argv[2], "crypt") == 0) {
         syntaxCrypt();
       }
+      else if (std::strcmp(argv[2], "batch") == 0) {
+        syntaxBatch();
+      }
       else if (std::strcmp(argv[2], "genKey") == 0) {
         syntaxGenerateKey();
       }
       else if (std::strcmp(argv[2], "genRot") == 0) {
         syntaxGenerateRotors();
       }
+      else if (std::strcmp(argv[2], "bench") == 0) {
+        syntaxBenchmark();
+      }
       else {
         throw InvalidArgument("main", argv[2], "after <help>");
       }
@@ -68,7 +81,7 @@ int main(int argc, char** argv) {
           // get the rotors
           availableRotors = findRotors();
           if (availableRotors.length() == 0) {
-            generateRotor(VALID_ROT_NAMES.c_str());
+            generateRotor(VALID_ROT_NAMES.c_str(), 0, options);
             availableRotors = VALID_ROT_NAMES;
           }
         }
@@ -79,7 +92,8 @@ int main(int argc, char** argv) {
         const char* keyfile     = argv[2];
         std::string keyfilePath = std::string(keyfile);
         const size_t keylength  = atoi(argv[3]);
-        TuringaKey key          = generateTuringaKey(keylength, availableRotors);
+        TuringaKey key          = generateTuringaKey(keylength, availableRotors, options.minCycle);
+        stampRotorHash(key, STD_ROT_DIR.c_str());
         writeTuringaKey(keyfilePath + ".key", key);
         key.direction = decryption;
         writeTuringaKey(keyfilePath + "_inv.key", key);
@@ -94,32 +108,52 @@ int main(int argc, char** argv) {
     else if (std::strcmp(argv[1], "genRot") == 0) {
       if (argc == 2) {
         // generate all valid rotors with default seed 0
-        generateRotor(VALID_ROT_NAMES.c_str());
+        generateRotor(VALID_ROT_NAMES.c_str(), 0, options);
       }
       else if (argc == 3 && std::strcmp(argv[2], "-r") == 0) {
         // generate all valid rotors with random seed
-        generateRotor(VALID_ROT_NAMES.c_str(), generateSeed());
+        generateRotor(VALID_ROT_NAMES.c_str(), generateSeed(), options);
       }
       else if (argc == 3) {
         // generate rotors using the default seed 0
-        generateRotor(argv[2]);
+        generateRotor(argv[2], 0, options);
       }
       else if (argc == 4 && std::strcmp(argv[2], "-a") == 0) {
         // generate all valid rotors with given seed
-        generateRotor(VALID_ROT_NAMES.c_str(), std::strtoull(argv[3], nullptr, 10));
+        generateRotor(VALID_ROT_NAMES.c_str(), std::strtoull(argv[3], nullptr, 10), options);
       }
       else if (argc == 4 && std::strcmp(argv[3], "-r") == 0) {
         // generate rotors using a random seed
-        generateRotor(argv[2], generateSeed());
+        generateRotor(argv[2], generateSeed(), options);
       }
       else if (argc == 4) {
         // generate rotors using a given seed
-        generateRotor(argv[2], std::strtoull(argv[3], nullptr, 10));
+        generateRotor(argv[2], std::strtoull(argv[3], nullptr, 10), options);
       }
       else {
         throw InappropriateNumberOfArguments("main", 4, argc);
       }
     }
+    // pack the rotor files into a bundle
+    else if (std::strcmp(argv[1], "bundle") == 0) {
+      if (argc > 3) {
+        throw InappropriateNumberOfArguments("main", 3, argc);
+      }
+      writeRotorBundle((argc == 3) ? argv[2] : STD_ROT_DIR);
+    }
+    // measure the throughput of the kernels
+    else if (std::strcmp(argv[1], "bench") == 0) {
+      if (argc > 3) {
+        throw InappropriateNumberOfArguments("main", 3, argc);
+      }
+      const size_t count = (argc == 3) ? std::strtoull(argv[2], nullptr, 10) : STD_BENCH_STATES;
+      if (count == 0) {
+        throw InvalidArgument("main", argv[2], "as number of states");
+      }
+      benchmarkRotate(count);
+      benchmarkSubstitute();
+      benchmarkChaCha();
+    }
     // encrypt or decrypt
     else if (std::strcmp(argv[1], "crypt") == 0) {
       if (argc <= 5) {
@@ -129,9 +163,21 @@ int main(int argc, char** argv) {
       const char* keyfile      = argv[3];
       const char* rotDirectory = argv[4];
       const char* outputfile   = argv[5];
-      TuringaKey key           = readTuringaKey(keyfile);
+      // the log must not mix with the data written to stdout
+      if (outputfile == PIPE_NAME) {
+        std::cout.rdbuf(std::cerr.rdbuf());
+      }
+      TuringaKey key = readTuringaKey(keyfile);
       assert((key.direction == encryption || key.direction == decryption) && "the key ins't read correctly");
-      handleCrypt(filename, outputfile, rotDirectory, key);
+      handleCrypt(filename, outputfile, rotDirectory, key, options);
+    }
+    // encrypt or decrypt many files
+    else if (std::strcmp(argv[1], "batch") == 0) {
+      if (argc <= 5) {
+        throw InappropriateNumberOfArguments("main", 6, argc);
+      }
+      TuringaKey key = readTuringaKey(argv[3]);
+      handleBatch(argv[2], argv[5], argv[4], key, options);
     }
     // decrypt file
     else if (std::strcmp(argv[1], "-d") == 0) {
@@ -145,7 +191,7 @@ int main(int argc, char** argv) {
       TuringaKey key = readTuringaKey((STD_KEY_DIR + STD_KEY_INV).c_str());
       std::string outputfilename(filename);
       outputfilename = outputfilename.substr(0, outputfilename.length() - 4);
-      handleCrypt(filename, outputfilename.c_str(), STD_ROT_DIR.c_str(), key);
+      handleCrypt(filename, outputfilename.c_str(), STD_ROT_DIR.c_str(), key, options);
     }
     // testing
     else if (std::strcmp(argv[1], "-t") == 0) {
@@ -161,12 +207,23 @@ int main(int argc, char** argv) {
           writeTuringaKey((STD_KEY_DIR + STD_KEY_INV).c_str(), key);
           key.direction = encryption;
         }
-        findCycle(key.rotorShifts);
+        testCycles({key}, STD_CYCLE_ITERATIONS);
         freeTuringaKey(key);
       }
+      else if (argc >= 4) {
+        // test all given keys in parallel
+        const size_t maxIter = std::strtoull(argv[2], nullptr, 10);
+        std::vector<TuringaKey> keys;
+        for (int i = 3; i < argc; ++i) {
+          keys.push_back(readTuringaKey(argv[i]));
+        }
+        testCycles(keys, maxIter);
+        for (TuringaKey& key : keys) {
+          freeTuringaKey(key);
+        }
+      }
       else {
-        // not special treatment for this case implemented yet
-        throw InappropriateNumberOfArguments("main", 2, argc);
+        throw InappropriateNumberOfArguments("main", 4, argc);
       }
     }
     else {
@@ -186,7 +243,7 @@ int main(int argc, char** argv) {
         }
         std::string outputfilename(filename);
         outputfilename += ".tur";
-        handleCrypt(filename, outputfilename.c_str(), STD_ROT_DIR.c_str(), key);
+        handleCrypt(filename, outputfilename.c_str(), STD_ROT_DIR.c_str(), key, options);
       }
       else {
         throw InvalidArgument("main", argv[1], "as first argument");
@@ -0,0 +1,85 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "mappedfile.hpp"
+
+#include "errors.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char* filename, const MapMode mode, const size_t size) :
+  p_descriptor(-1), p_bytes(nullptr), p_size(size), p_filename(filename) {
+  const int flags = (mode == readOnly) ? O_RDONLY : (mode == readWrite) ? O_RDWR : (O_RDWR | O_CREAT | O_TRUNC);
+  p_descriptor    = open(filename, flags, 0644);
+  if (p_descriptor < 0) {
+    if (mode == create) {
+      throw CannotCreateFile("MappedFile", filename);
+    }
+    throw FileNotFound("MappedFile", filename);
+  }
+  // the destructor does not run if the constructor throws, so the descriptor has to be closed before
+  const auto fail = [this](const char* operation) {
+    close(p_descriptor);
+    throw FileAccessFailed("MappedFile", p_filename, operation);
+  };
+
+  if (mode == create) {
+    // reserve the blocks up front, file systems without fallocate get a sparse file
+    if (ftruncate(p_descriptor, size) != 0) {
+      fail("resize");
+    }
+    if (size > 0) {
+      (void) posix_fallocate(p_descriptor, 0, size);
+    }
+  }
+  else {
+    struct stat status;
+    if (fstat(p_descriptor, &status) != 0) {
+      fail("stat");
+    }
+    p_size = status.st_size;
+  }
+
+  // mmap rejects empty mappings
+  if (p_size > 0) {
+    const int protection = (mode == readOnly) ? PROT_READ : (PROT_READ | PROT_WRITE);
+    void* memory         = mmap(nullptr, p_size, protection, MAP_SHARED, p_descriptor, 0);
+    if (memory == MAP_FAILED) {
+      fail("map");
+    }
+    p_bytes = static_cast<Byte*>(memory);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (p_bytes != nullptr) {
+    munmap(p_bytes, p_size);
+  }
+  close(p_descriptor);
+}
+#else
+MappedFile::MappedFile(const char* filename, const MapMode, const size_t) :
+  p_descriptor(-1), p_bytes(nullptr), p_size(0), p_filename(filename) {
+  throw InvalidArgument("MappedFile", filename, "for memory mapping, which is only supported on POSIX systems");
+}
+
+MappedFile::~MappedFile() = default;
+#endif
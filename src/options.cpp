@@ -0,0 +1,169 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "options.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include "constants.hpp"
+#include "errors.hpp"
+#include "processors.hpp"
+
+size_t parseSize(const std::string& value, const std::string& option) {
+  char* end;
+  errno             = 0;
+  const auto parsed = std::strtoull(value.c_str(), &end, 10);
+  // strtoull silently negates a leading minus and saturates on overflow
+  if (end == value.c_str() || value.find('-') != std::string::npos || errno == ERANGE
+      || parsed > std::numeric_limits<size_t>::max()) {
+    throw InvalidArgument("parseSize", value, "as value of <" + option + ">");
+  }
+  const size_t size = parsed;
+  unsigned shift    = 0;
+  switch (*end) {
+  case '\0':
+    return size;
+  case 'k':
+  case 'K':
+    shift = 10;
+    break;
+  case 'm':
+  case 'M':
+    shift = 20;
+    break;
+  case 'g':
+  case 'G':
+    shift = 30;
+    break;
+  default:
+    throw InvalidArgument("parseSize", value, "as value of <" + option + ">");
+  }
+  if (*(end + 1) != '\0' || size > (std::numeric_limits<size_t>::max() >> shift)) {
+    throw InvalidArgument("parseSize", value, "as value of <" + option + ">");
+  }
+  return size << shift;
+}
+
+CryptOptions extractOptions(int& argc, char** argv) {
+  CryptOptions options;
+  int remaining = 0;
+  for (int i = 0; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--", 2) != 0) {
+      argv[remaining++] = argv[i];
+      continue;
+    }
+    const std::string argument(argv[i]);
+    const size_t separator  = argument.find('=');
+    const std::string name  = argument.substr(0, separator);
+    const std::string value = (separator == std::string::npos) ? "" : argument.substr(separator + 1);
+
+    if (name == "--checkpoint-interval") {
+      options.checkpointInterval = parseSize(value, name);
+    }
+    else if (name == "--cache-size") {
+      options.cacheSize = parseSize(value, name);
+    }
+    else if (name == "--cache-dir" && !value.empty()) {
+      options.cacheDir = value;
+      if (options.cacheDir.back() != '/') {
+        options.cacheDir += '/';
+      }
+    }
+    else if (name == "--format" && (value == "v1" || value == "legacy")) {
+      options.format = legacy;
+    }
+    else if (name == "--format" && (value == "v2" || value == "chunked")) {
+      options.format = chunked;
+    }
+    else if (name == "--format" && (value == "v3" || value == "framed")) {
+      options.format = framed;
+    }
+    else if (name == "--chunk-size") {
+      options.chunkSize = parseSize(value, name);
+      if (options.chunkSize == 0) {
+        throw InvalidArgument("extractOptions", argument, "as chunk size");
+      }
+    }
+    else if (name == "--kernel" && !value.empty()) {
+      options.kernel = value;
+    }
+    else if (name == "--mode" && value == "interleaved") {
+      options.mode = interleaved;
+    }
+    else if (name == "--mode" && value == "pipelined") {
+      options.mode = pipelined;
+    }
+    else if (name == "--ring-depth") {
+      options.ringDepth = parseSize(value, name);
+      if (options.ringDepth == 0) {
+        throw InvalidArgument("extractOptions", argument, "as ring depth");
+      }
+    }
+    else if (name == "--min-cycle") {
+      options.minCycle = parseSize(value, name);
+    }
+    else if (name == "--block-size") {
+      options.blockSize = parseSize(value, name);
+      if (options.blockSize == 0) {
+        throw InvalidArgument("extractOptions", argument, "as block size");
+      }
+    }
+    else if (name == "--placement" && value == "heap") {
+      options.placement = heap;
+    }
+    else if (name == "--placement" && value == "local") {
+      options.placement = local;
+    }
+    else if (name == "--io" && value == "stdio") {
+      options.io = stdio;
+    }
+    else if (name == "--io" && value == "mmap") {
+      options.io = mapped;
+    }
+    else if (name == "--io" && value == "uring") {
+      options.io = uring;
+    }
+    else if (name == "--in-place" && value.empty()) {
+      options.inPlace = true;
+    }
+    else if (name == "--direct" && value.empty()) {
+      options.direct = true;
+    }
+    else if (name == "--distinct-rotors" && value.empty()) {
+      options.distinctRotors = true;
+    }
+    else if (name == "--memory") {
+      options.memory = parseSize(value, name);
+    }
+    else if (name == "--threads") {
+      options.threads = parseSize(value, name);
+      // more threads than processors only pay off a few times over, beyond that they exhaust the system
+      const size_t limit = MAX_THREADS_FACTOR * availableProcessors().count;
+      if (options.threads > limit) {
+        throw InvalidArgument(
+          "extractOptions", value, "as value of <" + name + ">, at most " + std::to_string(limit) + " threads");
+      }
+    }
+    else {
+      throw InvalidArgument("extractOptions", argument, "as option");
+    }
+  }
+  argc = remaining;
+  return options;
+}
@@ -0,0 +1,138 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include "constants.hpp"
+#include "rotate.hpp"
+#include "substitute.hpp"
+
+ScheduleRing::ScheduleRing(const size_t depth, const size_t blockSize)
+  : p_depth(depth), p_blockSize(blockSize), p_slots(depth * blockSize * MAX_KEYLENGTH), p_head(0), p_tail(0) {}
+
+Byte* ScheduleRing::reserve() noexcept {
+  std::unique_lock<std::mutex> lock(p_mutex);
+  p_changed.wait(lock, [this] { return p_head - p_tail < p_depth; });
+  return p_slots.data() + (p_head % p_depth) * p_blockSize * MAX_KEYLENGTH;
+}
+
+void ScheduleRing::publish() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(p_mutex);
+    ++p_head;
+  }
+  p_changed.notify_one();
+}
+
+const Byte* ScheduleRing::front() noexcept {
+  std::unique_lock<std::mutex> lock(p_mutex);
+  p_changed.wait(lock, [this] { return p_head != p_tail; });
+  return p_slots.data() + (p_tail % p_depth) * p_blockSize * MAX_KEYLENGTH;
+}
+
+void ScheduleRing::release() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(p_mutex);
+    ++p_tail;
+  }
+  p_changed.notify_one();
+}
+
+/*!
+ * class SteppingThread
+ * \brief long-lived thread running the stepping jobs of one substituting thread one after another
+ */
+class SteppingThread {
+private:
+  std::mutex p_mutex;                 /**< protects job, busy and stop */
+  std::condition_variable p_changed;  /**< wakes the thread on a new job and the owner when the job is done */
+  std::function<void()> p_job;        /**< job to be run next */
+  bool p_busy;                        /**< a job has been started and isn't finished yet */
+  bool p_stop;                        /**< tells the thread to terminate */
+  std::thread p_thread;               /**< the stepping thread, started last */
+
+  void work() {
+    std::unique_lock<std::mutex> lock(p_mutex);
+    while (true) {
+      p_changed.wait(lock, [this] { return p_busy || p_stop; });
+      if (!p_busy) {
+        return;
+      }
+      lock.unlock();
+      p_job();
+      lock.lock();
+      p_busy = false;
+      p_changed.notify_all();
+    }
+  }
+
+public:
+  SteppingThread() : p_busy(false), p_stop(false), p_thread(&SteppingThread::work, this) {}
+
+  // hands a job to the thread, the previous one has to be finished
+  void start(std::function<void()> job) {
+    {
+      std::lock_guard<std::mutex> lock(p_mutex);
+      p_job  = std::move(job);
+      p_busy = true;
+    }
+    p_changed.notify_all();
+  }
+
+  // waits until the current job is done
+  void finish() {
+    std::unique_lock<std::mutex> lock(p_mutex);
+    p_changed.wait(lock, [this] { return !p_busy; });
+  }
+
+  ~SteppingThread() {
+    {
+      std::lock_guard<std::mutex> lock(p_mutex);
+      p_stop = true;
+    }
+    p_changed.notify_all();
+    p_thread.join();
+  }
+};
+
+// writes the rotor states of all positions block by block into the ring
+static void produceSchedule(ScheduleRing& ring, Byte* rotorShifts, const size_t length, const size_t blockSize) {
+  for (size_t begin = 0; begin < length; begin += blockSize) {
+    schedule(ring.reserve(), std::min(blockSize, length - begin), rotorShifts);
+    ring.publish();
+  }
+}
+
+void substitutePipelined(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors, const size_t depth,
+  const size_t blockSize) {
+  // one stepping thread per substituting thread, so pool workers don't start a thread per block
+  static thread_local SteppingThread stepping;
+  ScheduleRing ring(depth, blockSize);
+  stepping.start([&ring, &key, length, blockSize] { produceSchedule(ring, key.rotorShifts, length, blockSize); });
+
+  for (size_t begin = 0; begin < length; begin += blockSize) {
+    substituteScheduled(bytes + begin, std::min(blockSize, length - begin), key, ring.front(), rotors);
+    ring.release();
+  }
+  stepping.finish();
+}
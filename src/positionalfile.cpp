@@ -0,0 +1,113 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "positionalfile.hpp"
+
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <algorithm>
+#include <io.h>
+#include <mutex>
+#else
+#include <unistd.h>
+#endif
+
+#include "errors.hpp"
+
+#ifdef _WIN32
+// there is no pread on Windows, so seeking and reading must not be interleaved by other threads
+static std::mutex accessMutex;
+
+static long long pread(int descriptor, void* buffer, size_t length, uint64_t offset) {
+  std::lock_guard<std::mutex> lock(accessMutex);
+  if (_lseeki64(descriptor, offset, SEEK_SET) < 0) {
+    return -1;
+  }
+  return _read(descriptor, buffer, static_cast<unsigned int>(std::min<size_t>(length, 1 << 30)));
+}
+
+static long long pwrite(int descriptor, const void* buffer, size_t length, uint64_t offset) {
+  std::lock_guard<std::mutex> lock(accessMutex);
+  if (_lseeki64(descriptor, offset, SEEK_SET) < 0) {
+    return -1;
+  }
+  return _write(descriptor, buffer, static_cast<unsigned int>(std::min<size_t>(length, 1 << 30)));
+}
+#endif
+
+PositionalFile::PositionalFile(const char* filename, const bool write) : p_filename(filename) {
+#ifdef _WIN32
+  const int flags = write ? (_O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY) : (_O_RDONLY | _O_BINARY);
+  p_descriptor    = _open(filename, flags, _S_IREAD | _S_IWRITE);
+#else
+  const int flags = write ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY;
+  p_descriptor    = open(filename, flags, 0644);
+#endif
+  if (p_descriptor < 0) {
+    if (write) {
+      throw CannotCreateFile("PositionalFile", filename);
+    }
+    throw FileNotFound("PositionalFile", filename);
+  }
+}
+
+void PositionalFile::read(Byte* bytes, const size_t length, const uint64_t offset) const {
+  size_t done = 0;
+  while (done < length) {
+    // pread may return less bytes than requested
+    const auto count = pread(p_descriptor, bytes + done, length - done, offset + done);
+    if (count <= 0) {
+      throw FileAccessFailed("PositionalFile::read", p_filename, "read");
+    }
+    done += count;
+  }
+}
+
+void PositionalFile::write(const Byte* bytes, const size_t length, const uint64_t offset) const {
+  size_t done = 0;
+  while (done < length) {
+    const auto count = pwrite(p_descriptor, bytes + done, length - done, offset + done);
+    if (count <= 0) {
+      throw FileAccessFailed("PositionalFile::write", p_filename, "write");
+    }
+    done += count;
+  }
+}
+
+void PositionalFile::reserve(const uint64_t size) const {
+#ifdef _WIN32
+  if (_chsize_s(p_descriptor, size) != 0) {
+    throw FileAccessFailed("PositionalFile::reserve", p_filename, "resize");
+  }
+#else
+  if (ftruncate(p_descriptor, size) != 0) {
+    throw FileAccessFailed("PositionalFile::reserve", p_filename, "resize");
+  }
+  if (size > 0) {
+    (void) posix_fallocate(p_descriptor, 0, size);
+  }
+#endif
+}
+
+PositionalFile::~PositionalFile() {
+#ifdef _WIN32
+  _close(p_descriptor);
+#else
+  close(p_descriptor);
+#endif
+}
@@ -0,0 +1,125 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "processors.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifdef __linux__
+// cpu quota in the cgroup directory dir and all its parents up to mount, 0 if unlimited
+static size_t cgroupQuota(const std::string& mount, std::string dir, const bool v2) {
+  size_t quota = 0;
+  while (true) {
+    double limit = 0, period = 0;
+    if (v2) {
+      // cpu.max contains "max <period>" or "<limit> <period>"
+      std::ifstream file(mount + dir + "/cpu.max");
+      std::string first;
+      if (file >> first >> period && first != "max") {
+        limit = std::stod(first);
+      }
+    }
+    else {
+      // cpu.cfs_quota_us is -1 if unlimited
+      std::ifstream quotaFile(mount + dir + "/cpu.cfs_quota_us"), periodFile(mount + dir + "/cpu.cfs_period_us");
+      quotaFile >> limit;
+      periodFile >> period;
+    }
+    if (limit > 0 && period > 0) {
+      const size_t count = std::max<size_t>(static_cast<size_t>(limit / period + 0.999), 1);
+      quota              = (quota == 0) ? count : std::min(quota, count);
+    }
+    // the path in /proc/self/cgroup may belong to the host, so the parents are tested too
+    if (dir.empty() || dir == "/") {
+      return quota;
+    }
+    dir = dir.substr(0, dir.find_last_of('/'));
+  }
+}
+
+// smallest cpu quota of the cgroups of this process, 0 if unlimited
+static size_t cgroupQuota(std::string& source) {
+  // lines look like "0::/path" for cgroup v2 and "3:cpu,cpuacct:/path" for cgroup v1
+  std::ifstream file("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(file, line)) {
+    const size_t first = line.find(':'), second = line.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos) {
+      continue;
+    }
+    const std::string controllers = line.substr(first + 1, second - first - 1);
+    const std::string path        = line.substr(second + 1);
+    size_t quota                  = 0;
+    if (controllers.empty()) {
+      quota = cgroupQuota("/sys/fs/cgroup", path, true);
+      if (quota == 0) {
+        // hybrid layout
+        quota = cgroupQuota("/sys/fs/cgroup/unified", path, true);
+      }
+      source = "cgroup v2 cpu.max";
+    }
+    else {
+      std::stringstream list(controllers);
+      std::string controller;
+      while (std::getline(list, controller, ',')) {
+        if (controller == "cpu") {
+          quota = cgroupQuota("/sys/fs/cgroup/" + controllers, path, false);
+          if (quota == 0) {
+            quota = cgroupQuota("/sys/fs/cgroup/cpu", path, false);
+          }
+          source = "cgroup v1 cpu.cfs_quota_us";
+        }
+      }
+    }
+    if (quota != 0) {
+      return quota;
+    }
+  }
+  return 0;
+}
+#endif
+
+const ProcessorBudget& availableProcessors() {
+  static const ProcessorBudget budget = []() {
+    // hardware_concurrency may return 0 if the number is not computable
+    const size_t installed = std::thread::hardware_concurrency();
+    ProcessorBudget result{std::max<size_t>(installed, 1), installed, "std::thread::hardware_concurrency"};
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+      result.count  = CPU_COUNT(&set);
+      result.source = "affinity mask";
+    }
+    std::string source;
+    const size_t quota = cgroupQuota(source);
+    if (quota != 0 && quota < result.count) {
+      result.count  = quota;
+      result.source = source;
+    }
+#endif
+    return result;
+  }();
+  return budget;
+}
@@ -17,223 +17,245 @@
  */
 #include "rotate.hpp"
 
-#if defined(__SSE4_1__) || defined(__AVX2__)
-#include <immintrin.h>
-#else
-#include <stdlib.h>
-#endif
+#include <cstring>
 
-#include "constants.hpp"
+#include "rotatekernels.hpp"
 
 // rotates the wheels,
 // wheel rotation is determined by a bent function on the current state of rotorShifts
 void rotate(Byte* rotorShifts) {
-/***************************************************************************************************
- *                                      AVX2 version
- **************************************************************************************************/
-#if defined(__AVX2__)
-// disable gcc warning -Woverflow
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Woverflow"
-  const __m256i low     = _mm256_set1_epi8(0b00001111);  // low bit mask
-  const __m256i reverse = _mm256_setr_epi8(
-    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
-  const __m256i table = _mm256_setr_epi8(
-    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
-    0b0011, 0b1000, 0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101,
-    0b1010, 0b0100, 0b0011, 0b1000);  // lookup table for inverting
-  const __m256i lookup_sum = _mm256_setr_epi8(
-    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
-    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b00000000, 0b11111111,
-    0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b00000000,
-    0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000);
-  const __m256i rotor_intervals = _mm256_setr_epi8(
-    1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31, 33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59,
-    61, 63);  // lookup table: i-th entry is 2*i +1
-// enable gcc warning -Woverflow
-#pragma GCC diagnostic pop
-
-  __m128i a = _mm_loadu_si128(((__m128i*) rotorShifts));      // load the first 16 byte ino a
-  __m128i b = _mm_loadu_si128(((__m128i*) rotorShifts) + 1);  // load the last 16 byte into b
-
-  // spread each byte into 2 (only in the lower 8 bit)
-  __m256i x = _mm256_cvtepu8_epi16(a);
-  __m256i y = _mm256_cvtepu8_epi16(b);
-
-  // shift 4 bits to the left
-  __m256i x2 = _mm256_slli_epi16(x, 4);
-  __m256i y2 = _mm256_slli_epi16(y, 4);
-
-  __m256i x1, y1;
-
-  // take only the lower 4 bits of each byte
-  x1 = _mm256_and_si256(x, low);
-  x2 = _mm256_and_si256(x2, low);
-  y1 = _mm256_and_si256(y, low);
-  y2 = _mm256_and_si256(y2, low);
-
-  // obtain x and y by adding
-  x = _mm256_or_si256(x1, x2);
-  y = _mm256_or_si256(y1, y2);
-
-  // invert using the lookup table x[i] := table[x[i]]
-  x = _mm256_shuffle_epi8(table, x);
-
-  // invert the order of y
-  y = _mm256_permute2x128_si256(y, y, 0b00000001);  // swaps the first and the last 128 bits
-  y = _mm256_shuffle_epi8(y, reverse);
-
-  // take the "inner product" of x and y
-  __m256i z = _mm256_and_si256(x, y);              // elementwise and
-  z         = _mm256_shuffle_epi8(lookup_sum, z);  // sum over all elements using the lookup sum
-
-  // if the first entry is 0 invert enverything
-  __m256i mode = _mm256_set1_epi8(_mm256_extract_epi8(z, 0));
-  z            = _mm256_cmpeq_epi8(z, mode);
-
-  // set each position of z to 0 or rotor intervals and add to values
-  z              = _mm256_and_si256(z, rotor_intervals);
-  __m256i values = _mm256_set_m128i(b, a);      // concatinate a and b to obtain initial rotor shifts
-  values         = _mm256_add_epi8(values, z);  // add z to the values
-
-  _mm256_storeu_si256((__m256i*) rotorShifts, values);  // finally store rotor shifts
-/***************************************************************************************************
- *                                      SSE version
- **************************************************************************************************/
-#elif defined(__SSE4_1__)
-// disable gcc warning -Woverflow
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Woverflow"
-  const __m128i low_4_bits_mask  = _mm_set1_epi8(0b00001111);
-  const __m128i high_4_bits_mask = _mm_set1_epi8(0b11110000);
-
-  // table for inverting polynomial  in GF(2) of degree <= 3 mod x^4 + x +1
-  const __m128i reverseOrder = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
-  const __m128i table        = _mm_setr_epi8(
-    0b0000, 0b0001, 0b1001, 0b1110, 0b1101, 0b1011, 0b0111, 0b0110, 0b1111, 0b0010, 0b1100, 0b0101, 0b1010, 0b0100,
-    0b0011, 0b1000);
-  const __m128i lookup_sum = _mm_setr_epi8(
-    0b00000000, 0b11111111, 0b11111111, 0b00000000, 0b11111111, 0b00000000, 0b00000000, 0b11111111, 0b11111111,
-    0b00000000, 0b00000000, 0b11111111, 0b00000000, 0b11111111, 0b11111111, 0b00000000);
-  const __m128i rotor_intervals_1 = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
-  const __m128i rotor_intervals_2 = _mm_setr_epi8(33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63);
-  const __m128i shuffle_high      = _mm_setr_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
-// enable gcc warning -Woverflow
-#pragma GCC diagnostic pop
-
-  // load bytes from rotorShifts
-  __m128i values1 = _mm_loadu_si128((__m128i*) rotorShifts);
-  __m128i values2 = _mm_loadu_si128((__m128i*) rotorShifts + 1);
-
-  // prepair the vectors for scalar products
-  __m128i x1, x2, x3, x4, y1, y2, y3, y4;
-  // first stretch the bytes to the size of two bytes
-  x1 = _mm_cvtepu8_epi16(values1);
-  x3 = _mm_shuffle_epi8(values1, shuffle_high);
-  x3 = _mm_cvtepu8_epi16(x3);
-
-  // split vectors into 4 lower and 4 higher bits
-  x2 = _mm_and_si128(x1, high_4_bits_mask);
-  x1 = _mm_and_si128(x1, low_4_bits_mask);
-  x4 = _mm_and_si128(x3, high_4_bits_mask);
-  x3 = _mm_and_si128(x3, low_4_bits_mask);
-
-  // shift from higher 4 bits to lower 4 bits of next byte
-  x2 = _mm_slli_epi32(x2, 4);
-  x4 = _mm_slli_epi32(x4, 4);
-
-  // assemble the x vectors
-  x1 = _mm_add_epi8(x1, x2);
-  x2 = _mm_add_epi8(x3, x4);
-
-  // first stretch the bytes to the size of two bytes
-  y1 = _mm_cvtepu8_epi16(values2);
-  y3 = _mm_shuffle_epi8(values2, shuffle_high);
-  y3 = _mm_cvtepu8_epi16(y3);
-
-  // split vectors into 4 lower and 4 higher bits
-  y2 = _mm_and_si128(y1, high_4_bits_mask);
-  y1 = _mm_and_si128(y1, low_4_bits_mask);
-  y4 = _mm_and_si128(y3, high_4_bits_mask);
-  y3 = _mm_and_si128(y3, low_4_bits_mask);
-
-  // shift from higher 4 bits to lower 4 bits of next byte
-  y2 = _mm_slli_epi32(y2, 4);
-  y4 = _mm_slli_epi32(y4, 4);
-
-  // assemble the y vectors
-  y1 = _mm_add_epi8(y1, y2);
-  y2 = _mm_add_epi8(y3, y4);
-
-  // function pi(y)
-  x1 = _mm_shuffle_epi8(table, x1);  // maps x1[i] := table[x1[i]]
-  x2 = _mm_shuffle_epi8(table, x2);  // maps x2[i] := table[x2[i]]
-
-  // revert the order of the y
-  y1 = _mm_shuffle_epi8(y1, reverseOrder);
-  y2 = _mm_shuffle_epi8(y2, reverseOrder);
-
-  // the "inner product" of x and y
-  __m128i z1 = _mm_and_si128(x1, y2);
-  __m128i z2 = _mm_and_si128(x2, y1);
-  z1         = _mm_shuffle_epi8(lookup_sum, z1);
-  z2         = _mm_shuffle_epi8(lookup_sum, z2);
-
-  // if the first entry is 0 invert enverything
-  __m128i mode = _mm_set1_epi8(_mm_extract_epi8(z1, 0));
-  z1           = _mm_cmpeq_epi8(z1, mode);
-  z2           = _mm_cmpeq_epi8(z2, mode);
-
-  // multyply the indicatorvariable z with the shifts
-  z1 = _mm_and_si128(z1, rotor_intervals_1);
-  z2 = _mm_and_si128(z2, rotor_intervals_2);
-
-  // add rotorshift to rotors
-  values1 = _mm_add_epi8(values1, z1);
-  values2 = _mm_add_epi8(values2, z2);
-
-  // save the maipulated rotorshifts
-  _mm_storeu_si128((__m128i*) rotorShifts, values1);
-  _mm_storeu_si128((__m128i*) rotorShifts + 1, values2);
-#else
-  /***************************************************************************************************
-   *                                 standard version
-   **************************************************************************************************/
-  // table for inverting polynomial  in GF(2) of degree <= 3 mod x^4 + x +1
-  Byte* table = (Byte*) malloc(16);
-  table[0]    = 0b0000;
-  table[1]    = 0b0001;
-  table[2]    = 0b1001;
-  table[3]    = 0b1110;
-  table[4]    = 0b1101;
-  table[5]    = 0b1011;
-  table[6]    = 0b0111;
-  table[7]    = 0b0110;
-  table[8]    = 0b1111;
-  table[9]    = 0b0010;
-  table[10]   = 0b1100;
-  table[11]   = 0b0101;
-  table[12]   = 0b1010;
-  table[13]   = 0b0100;
-  table[14]   = 0b0011;
-  table[15]   = 0b1000;
-
-  Byte* x = (Byte*) malloc(MAX_KEYLENGTH * 2);
-  for (size_t i = 0; i < MAX_KEYLENGTH; i++) {
-    x[2 * i]     = rotorShifts[i] & 0b00001111;  // the rightmost bits
-    x[2 * i + 1] = rotorShifts[i] >> 4;          // the leftmost bits
-  }
-
-  ++rotorShifts[0];
-  Byte mode = table[x[0]] & x[2 * MAX_KEYLENGTH - 1];
-  mode      = !(__builtin_popcount(mode) & 0b00000001);
-
-  for (size_t i = 1; i < MAX_KEYLENGTH; i++) {
-    Byte val = table[x[i]];
-    val &= x[2 * MAX_KEYLENGTH - 1 - i];                                              // bitwise xor
-    rotorShifts[i] += (2 * i + 1) * ((mode ^ __builtin_popcount(val)) & 0b00000001);  // test val is uneven
-  }
-  free(table);
-  free(x);
+  KERNELS.rotate(rotorShifts);
+}
+
+RotateFunction rotateVariant(const Kernel kernel) {
+  switch (kernel) {
+#if defined(KERNEL_X86)
+  case avx512:
+    return rotate_avx512;
+  case avx2:
+    return rotate_avx2;
+  case sse4:
+    return rotate_sse4;
 #endif
+  default:
+    return rotate_generic;
+  }
+}
+
+void advance(Byte* rotorShifts, const size_t steps) {
+  KERNELS.advance(rotorShifts, steps, nullptr);
+}
+
+size_t advanceUntil(Byte* rotorShifts, const size_t steps, const Byte* target) {
+  return KERNELS.advance(rotorShifts, steps, target);
+}
+
+static size_t advance_generic(Byte* rotorShifts, const size_t steps, const Byte* target) {
+  for (size_t step = 0; step < steps; ++step) {
+    rotate_generic(rotorShifts);
+    if (target != nullptr && std::memcmp(rotorShifts, target, MAX_KEYLENGTH) == 0) {
+      return step + 1;
+    }
+  }
+  return steps;
+}
+
+#if defined(KERNEL_X86)
+// also used by the AVX2 and AVX-512 kernels, the two halves in 128 bit registers give the shortest chain of
+// dependent instructions
+TARGET_SSE4 static size_t advance_sse4(Byte* rotorShifts, const size_t steps, const Byte* target) {
+  __m128i first = _mm_loadu_si128((__m128i*) rotorShifts);
+  __m128i last  = _mm_loadu_si128((__m128i*) rotorShifts + 1);
+  size_t step   = 0;
+  if (target == nullptr) {
+    for (; step < steps; ++step) {
+      step_sse4(first, last);
+    }
+  }
+  else {
+    const __m128i targetFirst = _mm_loadu_si128((__m128i*) target);
+    const __m128i targetLast  = _mm_loadu_si128((__m128i*) target + 1);
+    while (step < steps) {
+      step_sse4(first, last);
+      ++step;
+      const __m128i equal = _mm_and_si128(_mm_cmpeq_epi8(first, targetFirst), _mm_cmpeq_epi8(last, targetLast));
+      if (_mm_movemask_epi8(equal) == 0xFFFF) {
+        break;
+      }
+    }
+  }
+  _mm_storeu_si128((__m128i*) rotorShifts, first);
+  _mm_storeu_si128((__m128i*) rotorShifts + 1, last);
+  return step;
+}
+#endif
+
+void rotate_n(Byte* states, const size_t count) {
+  KERNELS.rotate_n(states, count);
+}
+
+static void rotate_n_generic(Byte* states, const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    rotate_generic(states + MAX_KEYLENGTH * i);
+  }
+}
+
+#if defined(KERNEL_X86)
+// four states per iteration, so the independent dependency chains overlap
+TARGET_SSE4 static void rotate_n_sse4(Byte* states, const size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i* state = (__m128i*) (states + MAX_KEYLENGTH * i);
+    __m128i first0 = _mm_loadu_si128(state), last0 = _mm_loadu_si128(state + 1);
+    __m128i first1 = _mm_loadu_si128(state + 2), last1 = _mm_loadu_si128(state + 3);
+    __m128i first2 = _mm_loadu_si128(state + 4), last2 = _mm_loadu_si128(state + 5);
+    __m128i first3 = _mm_loadu_si128(state + 6), last3 = _mm_loadu_si128(state + 7);
+    step_sse4(first0, last0);
+    step_sse4(first1, last1);
+    step_sse4(first2, last2);
+    step_sse4(first3, last3);
+    _mm_storeu_si128(state, first0);
+    _mm_storeu_si128(state + 1, last0);
+    _mm_storeu_si128(state + 2, first1);
+    _mm_storeu_si128(state + 3, last1);
+    _mm_storeu_si128(state + 4, first2);
+    _mm_storeu_si128(state + 5, last2);
+    _mm_storeu_si128(state + 6, first3);
+    _mm_storeu_si128(state + 7, last3);
+  }
+  for (; i < count; ++i) {
+    __m128i* state = (__m128i*) (states + MAX_KEYLENGTH * i);
+    __m128i first = _mm_loadu_si128(state), last = _mm_loadu_si128(state + 1);
+    step_sse4(first, last);
+    _mm_storeu_si128(state, first);
+    _mm_storeu_si128(state + 1, last);
+  }
+}
+
+// two states per register, the lanes are regrouped into first and last halves
+TARGET_AVX2 static void rotate_n_avx2(Byte* states, const size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i* state  = (__m256i*) (states + MAX_KEYLENGTH * i);
+    const __m256i a = _mm256_loadu_si256(state), b = _mm256_loadu_si256(state + 1);
+    const __m256i c = _mm256_loadu_si256(state + 2), d = _mm256_loadu_si256(state + 3);
+    __m256i first0  = _mm256_permute2x128_si256(a, b, 0x20), last0 = _mm256_permute2x128_si256(a, b, 0x31);
+    __m256i first1  = _mm256_permute2x128_si256(c, d, 0x20), last1 = _mm256_permute2x128_si256(c, d, 0x31);
+    step_x2_avx2(first0, last0);
+    step_x2_avx2(first1, last1);
+    _mm256_storeu_si256(state, _mm256_permute2x128_si256(first0, last0, 0x20));
+    _mm256_storeu_si256(state + 1, _mm256_permute2x128_si256(first0, last0, 0x31));
+    _mm256_storeu_si256(state + 2, _mm256_permute2x128_si256(first1, last1, 0x20));
+    _mm256_storeu_si256(state + 3, _mm256_permute2x128_si256(first1, last1, 0x31));
+  }
+  for (; i < count; ++i) {
+    __m128i* state = (__m128i*) (states + MAX_KEYLENGTH * i);
+    __m128i first = _mm_loadu_si128(state), last = _mm_loadu_si128(state + 1);
+    step_sse4(first, last);
+    _mm_storeu_si128(state, first);
+    _mm_storeu_si128(state + 1, last);
+  }
+}
+
+AVX512_WARNINGS_OFF
+// four states per register, the lanes are regrouped into first and last halves
+TARGET_AVX512 static void rotate_n_avx512(Byte* states, const size_t count) {
+  const __m512i firstLanes = _mm512_setr_epi64(0, 1, 4, 5, 8, 9, 12, 13);
+  const __m512i lastLanes  = _mm512_setr_epi64(2, 3, 6, 7, 10, 11, 14, 15);
+  const __m512i lowStates  = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+  const __m512i highStates = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+  size_t i                 = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512i* state  = (__m512i*) (states + MAX_KEYLENGTH * i);
+    const __m512i a = _mm512_loadu_si512(state), b = _mm512_loadu_si512(state + 1);
+    const __m512i c = _mm512_loadu_si512(state + 2), d = _mm512_loadu_si512(state + 3);
+    __m512i first0  = _mm512_permutex2var_epi64(a, firstLanes, b);
+    __m512i last0   = _mm512_permutex2var_epi64(a, lastLanes, b);
+    __m512i first1  = _mm512_permutex2var_epi64(c, firstLanes, d);
+    __m512i last1   = _mm512_permutex2var_epi64(c, lastLanes, d);
+    step_x4_avx512(first0, last0);
+    step_x4_avx512(first1, last1);
+    _mm512_storeu_si512(state, _mm512_permutex2var_epi64(first0, lowStates, last0));
+    _mm512_storeu_si512(state + 1, _mm512_permutex2var_epi64(first0, highStates, last0));
+    _mm512_storeu_si512(state + 2, _mm512_permutex2var_epi64(first1, lowStates, last1));
+    _mm512_storeu_si512(state + 3, _mm512_permutex2var_epi64(first1, highStates, last1));
+  }
+  rotate_n_avx2(states + MAX_KEYLENGTH * i, count - i);
+}
+AVX512_WARNINGS_ON
+#endif
+
+void schedule(Byte* states, const size_t count, Byte* rotorShifts) {
+  KERNELS.schedule(states, count, rotorShifts);
+}
+
+static void schedule_generic(Byte* states, const size_t count, Byte* rotorShifts) {
+  const RotateFunction rotate = KERNELS.rotate;
+  for (size_t i = 0; i < count; ++i) {
+    std::memcpy(states + MAX_KEYLENGTH * i, rotorShifts, MAX_KEYLENGTH);
+    rotate(rotorShifts);
+  }
+}
+
+#if defined(KERNEL_X86)
+TARGET_AVX2 static void schedule_avx2(Byte* states, const size_t count, Byte* rotorShifts) {
+  __m256i state = _mm256_loadu_si256((__m256i*) rotorShifts);
+  for (size_t i = 0; i < count; ++i) {
+    _mm256_storeu_si256((__m256i*) (states + MAX_KEYLENGTH * i), state);
+    state = step_avx2(state);
+  }
+  _mm256_storeu_si256((__m256i*) rotorShifts, state);
+}
+
+AVX512_WARNINGS_OFF
+TARGET_AVX512 static void schedule_avx512(Byte* states, const size_t count, Byte* rotorShifts) {
+  __m256i state = _mm256_loadu_si256((__m256i*) rotorShifts);
+  for (size_t i = 0; i < count; ++i) {
+    _mm256_storeu_si256((__m256i*) (states + MAX_KEYLENGTH * i), state);
+    state = step_avx512(state);
+  }
+  _mm256_storeu_si256((__m256i*) rotorShifts, state);
+}
+AVX512_WARNINGS_ON
+#endif
+
+ScheduleFunction scheduleVariant(const Kernel kernel) {
+  switch (kernel) {
+#if defined(KERNEL_X86)
+  case avx512:
+    return schedule_avx512;
+  case avx2:
+    return schedule_avx2;
+#endif
+  default:
+    return schedule_generic;
+  }
+}
+
+AdvanceFunction advanceVariant(const Kernel kernel) {
+  switch (kernel) {
+#if defined(KERNEL_X86)
+  case avx512:
+  case avx2:
+  case sse4:
+    return advance_sse4;
+#endif
+  default:
+    return advance_generic;
+  }
+}
+
+RotateNFunction rotateNVariant(const Kernel kernel) {
+  switch (kernel) {
+#if defined(KERNEL_X86)
+  case avx512:
+    return rotate_n_avx512;
+  case avx2:
+    return rotate_n_avx2;
+  case sse4:
+    return rotate_n_sse4;
+#endif
+  default:
+    return rotate_n_generic;
+  }
 }
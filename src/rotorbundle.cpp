@@ -0,0 +1,219 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "rotorbundle.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "checkpoint.hpp"
+#include "constants.hpp"
+#include "errors.hpp"
+#include "measurement.hpp"
+
+static const char BUNDLE_MAGIC[4]    = {'T', 'R', 'O', 'T'};
+static const uint32_t BUNDLE_VERSION = 1;
+static const size_t BUNDLE_HEADER    = sizeof(BUNDLE_MAGIC) + 3 * sizeof(uint32_t);  // version, rotors and tables
+static const size_t BUNDLE_ENTRY     = 2 * sizeof(uint64_t);  // name padded to 4 bytes, table and hash
+static const size_t BUNDLE_TABLES    = 2 * 256;               // permutation and inverse
+
+// reads the i-th 32 bit field after the magic bytes
+static uint32_t field(const Byte* bytes, const size_t i) {
+  uint32_t value;
+  std::memcpy(&value, bytes + sizeof(BUNDLE_MAGIC) + i * sizeof(uint32_t), sizeof(uint32_t));
+  return value;
+}
+
+// tells whether inverse undoes permutation, which implies that both are permutations
+static bool inverts(const Byte* permutation, const Byte* inverse) {
+  for (size_t i = 0; i < 256; ++i) {
+    if (inverse[permutation[i]] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RotorBundle::RotorBundle(const std::string& filename) :
+  p_bytes(nullptr), p_count(0), p_distinct(0), p_filename(filename) {
+  std::fill(p_index, p_index + 256, -1);
+  size_t size = 0;
+#ifdef _WIN32
+  FILE* myfile = fopen(filename.c_str(), "rb");
+  if (!myfile) {
+    throw FileNotFound("RotorBundle", filename);
+  }
+  p_copy.resize(std::filesystem::file_size(filename));
+  size = fread(p_copy.data(), 1, p_copy.size(), myfile);
+  fclose(myfile);
+  p_bytes = p_copy.data();
+#else
+  p_mapping = std::make_unique<MappedFile>(filename.c_str(), readOnly);
+  p_bytes   = p_mapping->bytes();
+  size      = p_mapping->size();
+#endif
+
+  const uint32_t version = (size >= BUNDLE_HEADER) ? field(p_bytes, 0) : 0;
+  const size_t count     = (size >= BUNDLE_HEADER) ? field(p_bytes, 1) : 0;
+  const size_t distinct  = (size >= BUNDLE_HEADER) ? field(p_bytes, 2) : 0;
+  if (
+    size < BUNDLE_HEADER || std::memcmp(p_bytes, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0
+    || version != BUNDLE_VERSION || count > 256 || distinct > count
+    || size != BUNDLE_HEADER + count * BUNDLE_ENTRY + distinct * BUNDLE_TABLES) {
+    throw FileAccessFailed("RotorBundle", filename, "parse the rotor bundle");
+  }
+  p_count    = count;
+  p_distinct = distinct;
+
+  // every table is verified once, however many rotors share it
+  const Byte* tables = p_bytes + BUNDLE_HEADER + p_count * BUNDLE_ENTRY;
+  std::vector<uint64_t> hashes(p_distinct);
+  for (size_t t = 0; t < p_distinct; ++t) {
+    const Byte* table = tables + t * BUNDLE_TABLES;
+    if (!inverts(table, table + 256)) {
+      throw FileAccessFailed("RotorBundle", filename, "verify the rotors of");
+    }
+    hashes[t] = fingerprint(table, BUNDLE_TABLES);
+  }
+  for (size_t i = 0; i < p_count; ++i) {
+    const Byte* entry = p_bytes + BUNDLE_HEADER + i * BUNDLE_ENTRY;
+    uint32_t t;
+    uint64_t stored;
+    std::memcpy(&t, entry + sizeof(uint32_t), sizeof(uint32_t));
+    std::memcpy(&stored, entry + sizeof(uint64_t), sizeof(uint64_t));
+    if (t >= p_distinct || stored != hashes[t] || p_index[entry[0]] >= 0) {
+      throw FileAccessFailed("RotorBundle", filename, "verify the rotors of");
+    }
+    p_index[entry[0]] = t;
+  }
+}
+
+std::string RotorBundle::names() const {
+  std::string names;
+  for (size_t i = 0; i < p_count; ++i) {
+    names += static_cast<char>(p_bytes[BUNDLE_HEADER + i * BUNDLE_ENTRY]);
+  }
+  return names;
+}
+
+const Byte* RotorBundle::table(const char name, const Direction direction) const {
+  const int index = p_index[static_cast<Byte>(name)];
+  if (index < 0) {
+    return nullptr;
+  }
+  const Byte* tables = p_bytes + BUNDLE_HEADER + p_count * BUNDLE_ENTRY;
+  return tables + index * BUNDLE_TABLES + ((direction == decryption) ? 256 : 0);
+}
+
+size_t RotorBundle::distinct() const noexcept {
+  return p_distinct;
+}
+
+std::string findRotorFiles(const std::string& directory) {
+  bool forward[256] = {false};
+  bool reverse[256] = {false};
+  std::error_code error;
+  for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+    const std::string name = entry.path().filename().string();
+    if (name.compare(0, 6, "rotor_") != 0) {
+      continue;
+    }
+    if (name.size() == 7) {
+      forward[static_cast<Byte>(name[6])] = true;
+    }
+    else if (name.size() == 15 && name.compare(7, 8, "_reverse") == 0) {
+      reverse[static_cast<Byte>(name[6])] = true;
+    }
+  }
+  std::string found;
+  for (const char name : VALID_ROT_NAMES) {
+    if (forward[static_cast<Byte>(name)] && reverse[static_cast<Byte>(name)]) {
+      found += name;
+    }
+  }
+  return found;
+}
+
+void writeRotorBundle(const std::string& directory) {
+  const std::string names = findRotorFiles(directory);
+  std::vector<Byte> index(names.size() * BUNDLE_ENTRY, 0);
+  std::vector<Byte> tables;
+  std::vector<uint64_t> hashes;
+  Byte table[BUNDLE_TABLES];
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::string filename;
+    for (size_t inverse = 0; inverse < 2; ++inverse) {
+      filename = (std::filesystem::path(directory) / ("rotor_" + names.substr(i, 1) + (inverse ? "_reverse" : "")))
+                   .string();
+      FILE* myfile = fopen(filename.c_str(), "rb");
+      if (!myfile) {
+        throw FileNotFound("writeRotorBundle", filename);
+      }
+      const size_t size = fread(table + 256 * inverse, 1, 256, myfile);
+      fclose(myfile);
+      if (size != 256) {
+        throw FileAccessFailed("writeRotorBundle", filename, "read 256 bytes of");
+      }
+    }
+    if (!inverts(table, table + 256)) {
+      throw FileAccessFailed("writeRotorBundle", filename, "verify the inverse rotor in");
+    }
+    // rotors generated together are identical and share their table
+    const uint64_t hash = fingerprint(table, BUNDLE_TABLES);
+    uint32_t t          = 0;
+    while (t < hashes.size() && (hashes[t] != hash || std::memcmp(&tables[t * BUNDLE_TABLES], table, BUNDLE_TABLES))) {
+      ++t;
+    }
+    if (t == hashes.size()) {
+      hashes.push_back(hash);
+      tables.insert(tables.end(), table, table + BUNDLE_TABLES);
+    }
+    Byte* entry = index.data() + i * BUNDLE_ENTRY;
+    entry[0]    = names[i];
+    std::memcpy(entry + sizeof(uint32_t), &t, sizeof(uint32_t));
+    std::memcpy(entry + sizeof(uint64_t), &hash, sizeof(uint64_t));
+  }
+  Byte header[BUNDLE_HEADER];
+  const uint32_t fields[3] = {
+    BUNDLE_VERSION, static_cast<uint32_t>(names.size()), static_cast<uint32_t>(hashes.size())};
+  std::memcpy(header, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+  std::memcpy(header + sizeof(BUNDLE_MAGIC), fields, sizeof(fields));
+
+  // processes still mapping the old bundle keep it until they unmap it
+  const std::string target    = (std::filesystem::path(directory) / ROTOR_BUNDLE).string();
+  const std::string temporary = target + ".tmp";
+  FILE* myfile                = fopen(temporary.c_str(), "wb");
+  if (!myfile) {
+    throw CannotCreateFile("writeRotorBundle", temporary);
+  }
+  size_t written = fwrite(header, 1, BUNDLE_HEADER, myfile);
+  written += fwrite(index.data(), 1, index.size(), myfile);
+  written += fwrite(tables.data(), 1, tables.size(), myfile);
+  if (fclose(myfile) != 0 || written != BUNDLE_HEADER + index.size() + tables.size()) {
+    throw FileAccessFailed("writeRotorBundle", temporary, "write");
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, target, error);
+  if (error) {
+    throw FileAccessFailed("writeRotorBundle", temporary, "rename");
+  }
+  std::cout << timestamp(current_duration()) << "Rotor bundle <" << target << "> with " << names.size()
+            << " rotors in " << hashes.size() << " distinct tables has been written.\n";
+}
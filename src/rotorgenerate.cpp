@@ -28,62 +28,94 @@
 #include "constants.hpp"
 #include "errors.hpp"
 #include "measurement.hpp"
+#include "rotorbundle.hpp"
+#include "threadpool.hpp"
+#include "turinga.hpp"
 #include "types.hpp"
 
-static Byte* order_256() {
-  Byte* order = (Byte*) malloc(256);
-  for (size_t i = 0; i < 256; ++i) {
-    order[i] = i;
-  }
-  return order;
-}
+#ifdef EMBEDDED_ROTOR_SEED
+// computed by the compiler, so crypt needs no rotor files
+static constexpr RotorTable EMBEDDED_ROTOR         = rotorPermutation(EMBEDDED_ROTOR_SEED);
+static constexpr RotorTable EMBEDDED_ROTOR_REVERSE = invertRotor(EMBEDDED_ROTOR);
+#endif
 
-static Byte* permutaion(Byte* array, const uint64_t givenSeed) {
-  // set up the chacha rng
-  uint32_t seed[12];
-  expandSeed(&seed[0], givenSeed);
+RotorTable distinctRotorPermutation(const uint64_t seed, const char name) {
+  // words 0 - 7 are the key, words 8 and 9 the block counter and words 10 and 11 the nonce
+  uint32_t expanded[12];
+  expandSeed(expanded, seed);
+  expanded[8]  = 0;
+  expanded[9]  = 0;
+  expanded[10] = static_cast<Byte>(name);
+  expanded[11] = 0;
   ChaCha rng;
-  rng.init(seed);
-
-  size_t a;
-  for (size_t i = 0; i < 256; ++i) {
-    a = rng.get() % (256 - i);
-    std::swap(array[a], array[255 - i]);
-  }
-  return array;
+  rng.init(expanded);
+  uint32_t words[256];
+  rng.generate((Byte*) words, sizeof(words));
+  return shuffleRotor(words);
 }
 
-static Byte* invert(const Byte* perm) {
-  Byte* inv_perm = (Byte*) malloc(256);
-  for (size_t i = 0; i < 256; ++i) {
-    inv_perm[perm[i]] = i;
+// writes the permutation of a rotor and its inverse
+static void writeRotor(const char rotorName, const RotorTable& perm) {
+  const RotorTable inv_perm = invertRotor(perm);
+  std::string name          = STD_ROT_DIR + "rotor_" + rotorName;
+  FILE* myfile              = fopen(name.c_str(), "wb");
+  if (!myfile) {
+    throw CannotCreateFile("generateRotor", name);
+  }
+  fwrite(perm.data(), 1, 256, myfile);
+  fclose(myfile);
+  name += "_reverse";
+  myfile = fopen(name.c_str(), "wb");
+  if (!myfile) {
+    throw CannotCreateFile("generateRotor", name);
   }
-  return inv_perm;
+  fwrite(inv_perm.data(), 1, 256, myfile);
+  fclose(myfile);
 }
 
-void generateRotor(const char* rotorNames, const uint64_t givenSeed) {
-  Byte* perm     = permutaion(order_256(), givenSeed);
-  Byte* inv_perm = invert(perm);
+void generateRotor(const char* rotorNames, const uint64_t givenSeed, const CryptOptions& options) {
   std::string str_rotorNames(rotorNames);
   std::filesystem::create_directory(STD_ROT_DIR);
-  for (size_t i = 0; i < str_rotorNames.length(); ++i) {
-    std::string name = STD_ROT_DIR + "rotor_" + str_rotorNames[i];
-    FILE* myfile     = fopen(name.c_str(), "wb");
-    if (!myfile) {
-      throw CannotCreateFile("generateRotor", name);
+  if (!options.distinctRotors) {
+    const RotorTable perm = rotorPermutation(givenSeed);
+    for (const char name : str_rotorNames) {
+      writeRotor(name, perm);
     }
-    fwrite(perm, 1, 256, myfile);
-    fclose(myfile);
-    name += "_reverse";
-    myfile = fopen(name.c_str(), "wb");
-    if (!myfile) {
-      throw CannotCreateFile("generateRotor", name);
+  }
+  else {
+    // the rotors don't depend on each other, so the threads compute and write them in any order
+    bool seen[256]   = {false};
+    ThreadPool& pool = cryptPool(options);
+    pool.limit(pool.size());
+    for (const char name : str_rotorNames) {
+      if (!seen[static_cast<Byte>(name)]) {
+        seen[static_cast<Byte>(name)] = true;
+        pool.submit([name, givenSeed]() { writeRotor(name, distinctRotorPermutation(givenSeed, name)); });
+      }
     }
-    fwrite(inv_perm, 1, 256, myfile);
-    fclose(myfile);
+    pool.wait();
   }
-  free(perm);
-  free(inv_perm);
   std::cout << timestamp(current_duration()) << "Rotors with the following names have been generated: <"
-            << str_rotorNames << "> Used seed: " << givenSeed << "\n";
+            << str_rotorNames << "> Used seed: " << givenSeed << (options.distinctRotors ? ", one stream per name" : "")
+            << "\n";
+  writeRotorBundle(STD_ROT_DIR);
+}
+
+std::string embeddedRotorNames() {
+#ifdef EMBEDDED_ROTOR_SEED
+  return VALID_ROT_NAMES;
+#else
+  return "";
+#endif
+}
+
+const Byte* embeddedRotor(const char name, const Direction direction) {
+#ifdef EMBEDDED_ROTOR_SEED
+  if (VALID_ROT_NAMES.find(name) != std::string::npos) {
+    return (direction == decryption) ? EMBEDDED_ROTOR_REVERSE.data() : EMBEDDED_ROTOR.data();
+  }
+#endif
+  (void) name;
+  (void) direction;
+  return nullptr;
 }
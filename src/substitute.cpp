@@ -0,0 +1,406 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "substitute.hpp"
+
+#include <array>
+#include <cassert>
+#include <utility>
+
+#include "rotatekernels.hpp"
+
+void substitute(Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors) {
+  assert(key.length <= MAX_KEYLENGTH && "the key is longer than the rotor shifts and kernel tables");
+  KERNELS.substitute(bytes, length, key, rotors);
+}
+
+void substituteScheduled(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* states, const Byte* rotors) {
+  assert(key.length <= MAX_KEYLENGTH && "the key is longer than the rotor shifts and kernel tables");
+  KERNELS.scheduled(bytes, length, key, states, rotors);
+}
+
+// passes one byte through all rotors using the given rotor state
+static inline Byte substitute_byte(Byte tmp, const TuringaKey& key, const Byte* rotorShifts, const Byte* rotors) {
+  const size_t keylength = key.length;
+  if (key.direction == encryption) {
+    for (size_t i = 0; i < keylength; ++i) {
+      tmp = rotors[256 * i + ((tmp + rotorShifts[i]) % 256)];
+    }
+  }
+  else {
+    for (size_t i = 0; i < keylength; ++i) {
+      tmp = rotors[256 * i + tmp] - rotorShifts[keylength - 1 - i];
+    }
+  }
+  return tmp;
+}
+
+/***************************************************************************************************
+ *                                 standard version
+ **************************************************************************************************/
+// passes one byte through sizeof...(I) rotors, the fold expression unrolls the chain completely
+template <Direction direction, size_t... I>
+static inline Byte chain_byte(Byte tmp, const Byte* rotorShifts, const Byte* rotors, std::index_sequence<I...>) {
+  if constexpr (direction == encryption) {
+    ((tmp = rotors[256 * I + ((tmp + rotorShifts[I]) % 256)]), ...);
+  }
+  else {
+    ((tmp = rotors[256 * I + tmp] - rotorShifts[sizeof...(I) - 1 - I]), ...);
+  }
+  return tmp;
+}
+
+// passes one byte through the rotors, keylength 0 stands for the loop over the rotors of the key
+template <size_t keylength, Direction direction>
+static inline Byte substitute_byte(Byte tmp, const TuringaKey& key, const Byte* rotorShifts, const Byte* rotors) {
+  if constexpr (keylength == 0) {
+    return substitute_byte(tmp, key, rotorShifts, rotors);
+  }
+  else {
+    return chain_byte<direction>(tmp, rotorShifts, rotors, std::make_index_sequence<keylength>());
+  }
+}
+
+template <size_t keylength, Direction direction>
+static void substitute_generic(Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors) {
+  const RotateFunction rotate = KERNELS.rotate;  // resolve the kernel once per call
+  for (size_t i = 0; i < length; ++i) {
+    bytes[i] = substitute_byte<keylength, direction>(bytes[i], key, key.rotorShifts, rotors);
+    rotate(key.rotorShifts);
+  }
+}
+
+template <size_t keylength, Direction direction>
+static void scheduled_generic(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* states, const Byte* rotors) {
+  for (size_t i = 0; i < length; ++i) {
+    bytes[i] = substitute_byte<keylength, direction>(bytes[i], key, states + MAX_KEYLENGTH * i, rotors);
+  }
+}
+
+/** instantiations of a kernel for every key length and both directions, key length 0 stands for the loop */
+using SubstituteTable = std::array<SubstituteFunction, 2 * (MAX_KEYLENGTH + 1)>;
+/** instantiations of a scheduled kernel for every key length and both directions */
+using ScheduledTable = std::array<ScheduledFunction, 2 * (MAX_KEYLENGTH + 1)>;
+
+template <size_t... L>
+static SubstituteTable substituteTable(std::index_sequence<L...>) {
+  return {substitute_generic<L, encryption>..., substitute_generic<L, decryption>...};
+}
+
+template <size_t... L>
+static ScheduledTable scheduledTable(std::index_sequence<L...>) {
+  return {scheduled_generic<L, encryption>..., scheduled_generic<L, decryption>...};
+}
+
+static const SubstituteTable SUBSTITUTE_GENERIC = substituteTable(std::make_index_sequence<MAX_KEYLENGTH + 1>());
+static const ScheduledTable SCHEDULED_GENERIC   = scheduledTable(std::make_index_sequence<MAX_KEYLENGTH + 1>());
+
+// calls the instantiation for the length and direction of the key
+static void dispatch_generic(Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors) {
+  SUBSTITUTE_GENERIC[key.direction * (MAX_KEYLENGTH + 1) + key.length](bytes, length, key, rotors);
+}
+
+static void dispatch_scheduled_generic(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* states, const Byte* rotors) {
+  SCHEDULED_GENERIC[key.direction * (MAX_KEYLENGTH + 1) + key.length](bytes, length, key, states, rotors);
+}
+
+// lookup_avx2 uses difference tables: for every rotor and both halves of 128 bytes the first row of 16 bytes is
+// stored unchanged, every further row is stored as xor with the previous row. XORing the rows 0 to j gives back row j.
+void deriveRotorTables(Byte* rotors, const size_t keylength) {
+  Byte* tables = rotors + 256 * MAX_KEYLENGTH;
+  for (size_t i = 0; i < 256 * keylength; ++i) {
+    tables[i] = (i % 128 < 16) ? rotors[i] : rotors[i] ^ rotors[i - 16];
+  }
+}
+
+#if defined(KERNEL_X86)
+/***************************************************************************************************
+ *                                      AVX2 version
+ **************************************************************************************************/
+static const size_t BLOCK_AVX2 = 32; /**< number of positions substituted at once */
+
+// transposes the rotor states, afterwards rows[i] contains the shift of rotor i for all 32 positions
+TARGET_AVX2 static inline void transpose_avx2(__m256i* rows) {
+  // each stage moves one bit of the register number into the byte number within the 128 bit lanes
+  for (size_t bit = 8; bit > 0; bit >>= 1) {
+    for (size_t r = 0; r < MAX_KEYLENGTH; ++r) {
+      if (r & bit) {
+        continue;
+      }
+      const __m256i a = rows[r];
+      const __m256i b = rows[r | bit];
+      rows[r]         = _mm256_unpacklo_epi8(a, b);
+      rows[r | bit]   = _mm256_unpackhi_epi8(a, b);
+    }
+  }
+  // finally exchange the lanes
+  for (size_t r = 0; r < MAX_KEYLENGTH / 2; ++r) {
+    const __m256i a = rows[r];
+    const __m256i b = rows[r + 16];
+    rows[r]         = _mm256_permute2x128_si256(a, b, 0x20);
+    rows[r + 16]    = _mm256_permute2x128_si256(a, b, 0x31);
+  }
+}
+
+// looks up 128 entries of a rotor, the index x must be below 128, pshufb yields 0 for rows after the one of x
+TARGET_AVX2 static inline __m256i lookup_half_avx2(const Byte* table, __m256i x) {
+  const __m256i row = _mm256_set1_epi8(16);
+  __m256i result    = _mm256_setzero_si256();
+  for (size_t j = 0; j < 8; ++j) {
+    const __m256i rows = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) (table + 16 * j)));
+    result             = _mm256_xor_si256(result, _mm256_shuffle_epi8(rows, x));
+    x                  = _mm256_sub_epi8(x, row);
+  }
+  return result;
+}
+
+// looks up all 32 bytes of x in a rotor given by its difference table, bit 7 selects the half
+TARGET_AVX2 static inline __m256i lookup_avx2(const Byte* table, const __m256i x) {
+  const __m256i index = _mm256_and_si256(x, _mm256_set1_epi8(0x7F));
+  return _mm256_blendv_epi8(lookup_half_avx2(table, index), lookup_half_avx2(table + 128, index), x);
+}
+
+// passes 32 bytes through the rotors, rows contains the transposed rotor states
+TARGET_AVX2 static inline __m256i chain_avx2(
+  __m256i x, const __m256i* rows, const TuringaKey& key, const Byte* tables) {
+  const size_t keylength = key.length;
+  if (key.direction == encryption) {
+    for (size_t i = 0; i < keylength; ++i) {
+      x = lookup_avx2(tables + 256 * i, _mm256_add_epi8(x, rows[i]));
+    }
+  }
+  else {
+    for (size_t i = 0; i < keylength; ++i) {
+      x = _mm256_sub_epi8(lookup_avx2(tables + 256 * i, x), rows[keylength - 1 - i]);
+    }
+  }
+  return x;
+}
+
+TARGET_AVX2 static void substitute_avx2(Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors) {
+  __m128i first = _mm_loadu_si128((__m128i*) key.rotorShifts);
+  __m128i last  = _mm_loadu_si128((__m128i*) key.rotorShifts + 1);
+  __m256i rows[MAX_KEYLENGTH];
+
+  size_t position = 0;
+  if (length >= BLOCK_AVX2) {
+    const Byte* tables = rotors + 256 * MAX_KEYLENGTH;
+
+    for (; position + BLOCK_AVX2 <= length; position += BLOCK_AVX2) {
+      // materialise the rotor states of the next 32 positions
+      for (size_t r = 0; r < BLOCK_AVX2; ++r) {
+        rows[r] = _mm256_set_m128i(last, first);
+        step_sse4(first, last);
+      }
+      transpose_avx2(rows);
+
+      // pass all 32 bytes through the rotors
+      const __m256i x = _mm256_loadu_si256((__m256i*) (bytes + position));
+      _mm256_storeu_si256((__m256i*) (bytes + position), chain_avx2(x, rows, key, tables));
+    }
+  }
+  _mm_storeu_si128((__m128i*) key.rotorShifts, first);
+  _mm_storeu_si128((__m128i*) key.rotorShifts + 1, last);
+
+  // the remaining bytes one by one
+  for (; position < length; ++position) {
+    bytes[position] = substitute_byte(bytes[position], key, key.rotorShifts, rotors);
+    rotate_avx2(key.rotorShifts);
+  }
+}
+
+TARGET_AVX2 static void scheduled_avx2(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* states, const Byte* rotors) {
+  __m256i rows[MAX_KEYLENGTH];
+
+  size_t position = 0;
+  if (length >= BLOCK_AVX2) {
+    const Byte* tables = rotors + 256 * MAX_KEYLENGTH;
+
+    for (; position + BLOCK_AVX2 <= length; position += BLOCK_AVX2) {
+      for (size_t r = 0; r < BLOCK_AVX2; ++r) {
+        rows[r] = _mm256_loadu_si256((__m256i*) (states + MAX_KEYLENGTH * (position + r)));
+      }
+      transpose_avx2(rows);
+
+      const __m256i x = _mm256_loadu_si256((__m256i*) (bytes + position));
+      _mm256_storeu_si256((__m256i*) (bytes + position), chain_avx2(x, rows, key, tables));
+    }
+  }
+
+  for (; position < length; ++position) {
+    bytes[position] = substitute_byte(bytes[position], key, states + MAX_KEYLENGTH * position, rotors);
+  }
+}
+
+/***************************************************************************************************
+ *                                     AVX-512 version
+ **************************************************************************************************/
+AVX512_WARNINGS_OFF
+static const size_t BLOCK_AVX512 = 64; /**< number of positions substituted at once */
+
+/*!
+ * \struct TransposeIndices
+ * \brief index vectors for vpermt2b to transpose the rotor states of 64 positions in 5 stages
+ * \details Before the transposition the rotor states of positions 2r and 2r + 1 are stored in register r. Stage s
+ * exchanges bit s of the register number with bit s of the byte number. The last stage also sorts the positions.
+ */
+struct TransposeIndices {
+  alignas(64) Byte index[5][2][64]; /**< indices for stage, lower or upper register and byte */
+};
+
+static TransposeIndices transposeIndices() {
+  TransposeIndices indices;
+  for (size_t stage = 0; stage < 5; ++stage) {
+    const size_t bit = (size_t) 1 << stage;
+    for (size_t upper = 0; upper < 2; ++upper) {
+      for (size_t lane = 0; lane < 64; ++lane) {
+        const size_t target = (stage == 4) ? ((lane & 1) << 5) | (lane >> 1) : lane;
+        const size_t source = (target & bit) ? 64 : 0;  // the exchanged bit selects the source register
+        indices.index[stage][upper][lane] = source | (target & ~bit) | (upper * bit);
+      }
+    }
+  }
+  return indices;
+}
+
+static const TransposeIndices TRANSPOSE_INDICES = transposeIndices();
+
+// transposes the rotor states, afterwards rows[i] contains the shift of rotor i for all 64 positions
+TARGET_AVX512 static inline void transpose_avx512(__m512i* rows) {
+  for (size_t stage = 0; stage < 5; ++stage) {
+    const size_t bit      = (size_t) 1 << stage;
+    const __m512i lower   = _mm512_load_si512(TRANSPOSE_INDICES.index[stage][0]);
+    const __m512i upper   = _mm512_load_si512(TRANSPOSE_INDICES.index[stage][1]);
+    for (size_t r = 0; r < MAX_KEYLENGTH; ++r) {
+      if (r & bit) {
+        continue;
+      }
+      const __m512i a = rows[r];
+      const __m512i b = rows[r | bit];
+      rows[r]         = _mm512_permutex2var_epi8(a, lower, b);
+      rows[r | bit]   = _mm512_permutex2var_epi8(a, upper, b);
+    }
+  }
+}
+
+// looks up all 64 bytes of x in a rotor, bit 7 of each byte selects between the two 128 byte halves
+TARGET_AVX512 static inline __m512i lookup_avx512(const Byte* rotor, const __m512i x) {
+  const __m512i low  = _mm512_permutex2var_epi8(_mm512_loadu_si512(rotor), x, _mm512_loadu_si512(rotor + 64));
+  const __m512i high = _mm512_permutex2var_epi8(_mm512_loadu_si512(rotor + 128), x, _mm512_loadu_si512(rotor + 192));
+  return _mm512_mask_blend_epi8(_mm512_movepi8_mask(x), low, high);
+}
+
+// passes 64 bytes through the rotors, rows contains the transposed rotor states
+TARGET_AVX512 static inline __m512i chain_avx512(
+  __m512i x, const __m512i* rows, const TuringaKey& key, const Byte* rotors) {
+  const size_t keylength = key.length;
+  if (key.direction == encryption) {
+    for (size_t i = 0; i < keylength; ++i) {
+      x = lookup_avx512(rotors + 256 * i, _mm512_add_epi8(x, rows[i]));
+    }
+  }
+  else {
+    for (size_t i = 0; i < keylength; ++i) {
+      x = _mm512_sub_epi8(lookup_avx512(rotors + 256 * i, x), rows[keylength - 1 - i]);
+    }
+  }
+  return x;
+}
+
+TARGET_AVX512 static void substitute_avx512(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* rotors) {
+  __m128i first = _mm_loadu_si128((__m128i*) key.rotorShifts);
+  __m128i last  = _mm_loadu_si128((__m128i*) key.rotorShifts + 1);
+  __m512i rows[MAX_KEYLENGTH];
+
+  size_t position = 0;
+  for (; position + BLOCK_AVX512 <= length; position += BLOCK_AVX512) {
+    // materialise the rotor states of the next 64 positions
+    for (size_t r = 0; r < MAX_KEYLENGTH; ++r) {
+      const __m256i even = _mm256_set_m128i(last, first);
+      step_sse4(first, last);
+      rows[r] = _mm512_inserti64x4(_mm512_zextsi256_si512(even), _mm256_set_m128i(last, first), 1);
+      step_sse4(first, last);
+    }
+    transpose_avx512(rows);
+
+    // pass all 64 bytes through the rotors
+    const __m512i x = _mm512_loadu_si512(bytes + position);
+    _mm512_storeu_si512(bytes + position, chain_avx512(x, rows, key, rotors));
+  }
+  _mm_storeu_si128((__m128i*) key.rotorShifts, first);
+  _mm_storeu_si128((__m128i*) key.rotorShifts + 1, last);
+
+  // the remaining bytes one by one
+  for (; position < length; ++position) {
+    bytes[position] = substitute_byte(bytes[position], key, key.rotorShifts, rotors);
+    rotate_avx512(key.rotorShifts);
+  }
+}
+
+TARGET_AVX512 static void scheduled_avx512(
+  Byte* bytes, const size_t length, const TuringaKey& key, const Byte* states, const Byte* rotors) {
+  __m512i rows[MAX_KEYLENGTH];
+
+  size_t position = 0;
+  for (; position + BLOCK_AVX512 <= length; position += BLOCK_AVX512) {
+    // the states of positions 2r and 2r + 1 are adjacent in the schedule
+    for (size_t r = 0; r < MAX_KEYLENGTH; ++r) {
+      rows[r] = _mm512_loadu_si512(states + MAX_KEYLENGTH * (position + 2 * r));
+    }
+    transpose_avx512(rows);
+
+    const __m512i x = _mm512_loadu_si512(bytes + position);
+    _mm512_storeu_si512(bytes + position, chain_avx512(x, rows, key, rotors));
+  }
+
+  for (; position < length; ++position) {
+    bytes[position] = substitute_byte(bytes[position], key, states + MAX_KEYLENGTH * position, rotors);
+  }
+}
+AVX512_WARNINGS_ON
+#endif
+
+SubstituteFunction substituteVariant(const Kernel kernel, const bool specialised) {
+  switch (kernel) {
+#if defined(KERNEL_X86)
+  case avx512:
+    return substitute_avx512;
+  case avx2:
+    return substitute_avx2;
+#endif
+  default:
+    return specialised ? dispatch_generic : SUBSTITUTE_GENERIC[0];
+  }
+}
+
+ScheduledFunction scheduledVariant(const Kernel kernel) {
+  switch (kernel) {
+#if defined(KERNEL_X86)
+  case avx512:
+    return scheduled_avx512;
+  case avx2:
+    return scheduled_avx2;
+#endif
+  default:
+    return dispatch_scheduled_generic;
+  }
+}
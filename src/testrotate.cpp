@@ -1,28 +1,101 @@
 #include "testrotate.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstring>
 #include <iostream>
+#include <thread>
 
 #include "constants.hpp"
 #include "measurement.hpp"
+#include "processors.hpp"
 #include "rotate.hpp"
 
-void findCycle(const Byte* rotorShifts, size_t maxIter) {
-  Byte* x = (Byte*) malloc(MAX_KEYLENGTH);
-  Byte* y = (Byte*) malloc(MAX_KEYLENGTH);
+static const size_t TAIL_BLOCK = 4096; /**< number of states compared at once while searching the tail */
+
+// the first state of the cycle is the first i with x_i = x_{i + length}, both sequences are scheduled block by block
+static size_t findTail(const Byte* rotorShifts, const size_t length, std::atomic<size_t>& progress) {
+  Byte x[MAX_KEYLENGTH];
+  Byte y[MAX_KEYLENGTH];
   std::memcpy(x, rotorShifts, MAX_KEYLENGTH);
   std::memcpy(y, rotorShifts, MAX_KEYLENGTH);
-  for (size_t iteration = 0; iteration < maxIter; ++iteration) {
-    rotate(x);
-    rotate(y);
-    rotate(y);
-    if (std::memcmp(x, y, MAX_KEYLENGTH) == 0) {
-      std::cerr << "cycle length is a divisor of " << iteration + 1 << ".\n";
-      break;
+  advance(y, length);
+  std::vector<Byte> xs(TAIL_BLOCK * MAX_KEYLENGTH), ys(TAIL_BLOCK * MAX_KEYLENGTH);
+  for (size_t tail = 0;; tail += TAIL_BLOCK) {
+    schedule(xs.data(), TAIL_BLOCK, x);
+    schedule(ys.data(), TAIL_BLOCK, y);
+    progress += 2 * TAIL_BLOCK;
+    for (size_t i = 0; i < TAIL_BLOCK; ++i) {
+      if (std::memcmp(xs.data() + MAX_KEYLENGTH * i, ys.data() + MAX_KEYLENGTH * i, MAX_KEYLENGTH) == 0) {
+        return tail + i;
+      }
+    }
+  }
+}
+
+CycleInfo findCycle(const Byte* rotorShifts, const size_t maxIter, std::atomic<size_t>& progress) {
+  using State = std::array<Byte, MAX_KEYLENGTH>;
+  State start;
+  std::memcpy(start.data(), rotorShifts, MAX_KEYLENGTH);
+  return brentCycle(
+    start, maxIter,
+    [](State& hare, const size_t steps, const State& target) {
+      return advanceUntil(hare.data(), steps, target.data());
+    },
+    [rotorShifts, &progress](const size_t length) { return findTail(rotorShifts, length, progress); }, progress);
+}
+
+std::vector<CycleInfo> findCycles(const Byte* states, const size_t count, const size_t maxIter, const bool verbose) {
+  std::vector<CycleInfo> cycles(count);
+  std::atomic<size_t> next(0), finished(0), progress(0);
+  const size_t threadcount = std::max<size_t>(std::min(availableProcessors().count, count), 1);
+
+  // every worker takes the next state until all are done
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threadcount; ++t) {
+    threads.push_back(std::thread([&]() {
+      for (size_t i = next++; i < count; i = next++) {
+        cycles[i] = findCycle(states + MAX_KEYLENGTH * i, maxIter, progress);
+        ++finished;
+      }
+    }));
+  }
+
+  const double start = current_duration();
+  double lastOutput  = start;
+  while (verbose && finished < count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (current_duration() - lastOutput >= 1) {
+      lastOutput            = current_duration();
+      const size_t done     = progress;
+      const double duration = lastOutput - start;
+      std::cout << timestamp(lastOutput) << "iterations checked: " << done << " (" << done / duration / 1e6
+                << " M/s), keys finished: " << finished << " of " << count << "\n";
+    }
+  }
+  for (std::thread& thr : threads) {
+    thr.join();
+  }
+  return cycles;
+}
+
+void testCycles(const std::vector<TuringaKey>& keys, const size_t maxIter) {
+  std::vector<Byte> states(keys.size() * MAX_KEYLENGTH);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::memcpy(states.data() + MAX_KEYLENGTH * i, keys[i].rotorShifts, MAX_KEYLENGTH);
+  }
+  std::cout << timestamp(current_duration()) << "Searching cycles of " << keys.size() << " key(s) up to " << maxIter
+            << " iterations.\n";
+  const std::vector<CycleInfo> cycles = findCycles(states.data(), keys.size(), maxIter, true);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::cout << timestamp(current_duration()) << "key " << i << ": ";
+    if (cycles[i].found) {
+      std::cout << "tail length " << cycles[i].tail << ", cycle length " << cycles[i].length << "\n";
     }
-    if ((iteration + 1) % (size_t) 1e7 == 0) {
-      std::cout << timestamp(current_duration()) << "iterations checked: " << iteration + 1 << "\n";
+    else {
+      std::cout << "no repetition within " << maxIter << " iterations\n";
     }
   }
-  std::cout << timestamp(current_duration()) << "check done!";
+  std::cout << timestamp(current_duration()) << "check done!\n";
 }
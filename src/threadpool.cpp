@@ -0,0 +1,257 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "measurement.hpp"
+
+// seconds elapsed since start
+static double elapsed(const time_point start) {
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+ThreadPool::ThreadPool(const size_t workers) :
+  p_queued(0), p_pending(0), p_width(workers + 1), p_next(0), p_stop(false) {
+  for (size_t i = 0; i <= workers; ++i) {
+    p_queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < workers; ++i) {
+    p_threads.push_back(std::thread(&ThreadPool::work, this, i));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(p_mutex);
+    p_stop = true;
+  }
+  p_wake.notify_all();
+  for (std::thread& thr : p_threads) {
+    thr.join();
+  }
+}
+
+size_t ThreadPool::size() const noexcept {
+  return p_queues.size();
+}
+
+// maps the i-th of the p_width threads taking part to its queue, the last one is the calling thread
+size_t ThreadPool::queueIndex(const size_t i) const noexcept {
+  return (i + 1 < p_width) ? i : p_queues.size() - 1;
+}
+
+void ThreadPool::limit(const size_t threads) {
+  p_width = std::clamp<size_t>(threads, 1, p_queues.size());
+  p_next  = 0;
+}
+
+size_t ThreadPool::pin() {
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+    return 0;
+  }
+  std::vector<int> processors;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &mask)) {
+      processors.push_back(cpu);
+    }
+  }
+  if (processors.empty()) {
+    return 0;
+  }
+  // worker i gets the i-th processor, the calling thread the one after the last worker
+  size_t pinned = 0;
+  for (size_t i = 0; i < p_queues.size(); ++i) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processors[i % processors.size()], &set);
+    const pthread_t thread = (i < p_threads.size()) ? p_threads[i].native_handle() : pthread_self();
+    if (pthread_setaffinity_np(thread, sizeof(set), &set) == 0) {
+      ++pinned;
+    }
+  }
+  return pinned;
+#else
+  return 0;
+#endif
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  Queue& queue = *p_queues[queueIndex(p_next)];
+  p_next       = (p_next + 1) % p_width;
+  ++p_pending;
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(p_mutex);
+    ++p_queued;
+  }
+  if (p_width > 1) {
+    p_wake.notify_all();
+  }
+}
+
+bool ThreadPool::take(const size_t self, std::function<void()>& task) {
+  // own queue first
+  {
+    Queue& queue = *p_queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      --p_queued;
+      return true;
+    }
+  }
+  // steal from the back of the others taking part
+  for (size_t i = 0; i < p_width; ++i) {
+    const size_t other = queueIndex(i);
+    if (other == self) {
+      continue;
+    }
+    Queue& queue = *p_queues[other];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      --p_queued;
+      std::lock_guard<std::mutex> own(p_queues[self]->mutex);
+      ++p_queues[self]->stolen;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::execute(const size_t self, std::function<void()>& task) {
+  const time_point start = std::chrono::high_resolution_clock::now();
+  try {
+    task();
+  } catch (...) {
+    // the other tasks still run to completion, wait() passes the failure on to the calling thread
+    std::lock_guard<std::mutex> lock(p_mutex);
+    if (!p_failure) {
+      p_failure = std::current_exception();
+    }
+  }
+  const double duration = elapsed(start);
+  {
+    std::lock_guard<std::mutex> lock(p_queues[self]->mutex);
+    ++p_queues[self]->executed;
+    p_queues[self]->busy += duration;
+  }
+  if (--p_pending == 0) {
+    std::lock_guard<std::mutex> lock(p_mutex);
+    p_done.notify_all();
+  }
+}
+
+void ThreadPool::work(const size_t self) {
+  std::function<void()> task;
+  while (true) {
+    if (take(self, task)) {
+      execute(self, task);
+      continue;
+    }
+    const time_point start = std::chrono::high_resolution_clock::now();
+    {
+      std::unique_lock<std::mutex> lock(p_mutex);
+      p_wake.wait(lock, [this, self]() { return (p_queued > 0 && self + 1 < p_width) || p_stop; });
+      if (p_stop) {
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> lock(p_queues[self]->mutex);
+    p_queues[self]->idle += elapsed(start);
+  }
+}
+
+void ThreadPool::wait() {
+  const size_t self = p_queues.size() - 1;
+  std::function<void()> task;
+  while (p_pending > 0) {
+    if (take(self, task)) {
+      execute(self, task);
+      continue;
+    }
+    // the remaining tasks are running in other threads
+    const time_point start = std::chrono::high_resolution_clock::now();
+    {
+      std::unique_lock<std::mutex> lock(p_mutex);
+      p_done.wait(lock, [this]() { return p_pending == 0; });
+    }
+    std::lock_guard<std::mutex> lock(p_queues[self]->mutex);
+    p_queues[self]->idle += elapsed(start);
+  }
+  std::exception_ptr failure;
+  {
+    std::lock_guard<std::mutex> lock(p_mutex);
+    std::swap(failure, p_failure);
+  }
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+}
+
+void ThreadPool::printStats() {
+  size_t executed = 0;
+  for (const std::unique_ptr<Queue>& queue : p_queues) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    executed += queue->executed;
+  }
+  std::cout << timestamp(current_duration()) << "Thread pool: " << executed << " tasks on " << p_width << " threads.\n";
+  for (size_t i = 0; i < p_queues.size(); ++i) {
+    Queue& queue = *p_queues[i];
+    if (i + 1 < p_queues.size() && i + 1 >= p_width) {
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    std::cout << timestamp(current_duration());
+    if (i + 1 < p_queues.size()) {
+      std::cout << "  worker " << std::setw(2) << i;
+    }
+    else {
+      std::cout << "  caller   ";
+    }
+    std::cout << ": " << queue.executed << " tasks (" << queue.stolen << " stolen), busy " << std::fixed
+              << std::setprecision(3) << queue.busy << " s, idle " << queue.idle << " s\n"
+              << std::defaultfloat;
+    queue.executed = 0;
+    queue.stolen   = 0;
+    queue.busy     = 0;
+    queue.idle     = 0;
+  }
+}
+
+ThreadPool& threadPool(const size_t workers) {
+  static ThreadPool pool(workers);
+  return pool;
+}
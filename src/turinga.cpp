@@ -17,26 +17,67 @@
  */
 #include "turinga.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 #include <thread>
 #include <vector>
 
 #include <csprng.hpp>
 
+#include "chacha.hpp"
+#include "checkpoint.hpp"
 #include "constants.hpp"
+#include "errors.hpp"
 #include "fileinteraction.hpp"
+#include "kernels.hpp"
 #include "measurement.hpp"
+#include "pipeline.hpp"
+#include "processors.hpp"
 #include "rotate.hpp"
 #include "rotorgenerate.hpp"
+#include "substitute.hpp"
+#include "testrotate.hpp"
 
-TuringaKey generateTuringaKey(const size_t keylength, const std::string& availableRotors) {
+// draws rotor states until one doesn't repeat within minCycle rotations, the candidates are tested in parallel
+static void drawRotorShifts(Byte* rotorShifts, const size_t minCycle, duthomhas::csprng& random) {
+  const size_t batch = availableProcessors().count;
+  std::vector<Byte> candidates(batch * MAX_KEYLENGTH);
+  for (size_t tested = 0; tested < MAX_KEY_CANDIDATES; tested += batch) {
+    for (Byte& candidate : candidates) {
+      candidate = random();
+    }
+    const std::vector<CycleInfo> cycles = findCycles(candidates.data(), batch, minCycle, false);
+    for (size_t i = 0; i < batch; ++i) {
+      if (!cycles[i].found) {
+        std::memcpy(rotorShifts, candidates.data() + MAX_KEYLENGTH * i, MAX_KEYLENGTH);
+        std::cout << timestamp(current_duration()) << "Rotor states don't repeat within " << minCycle
+                  << " rotations, " << tested + i << " candidates rejected.\n";
+        return;
+      }
+    }
+  }
+  throw InvalidArgument("generateTuringaKey", std::to_string(minCycle), "as minimal cycle, no candidate passed");
+}
+
+TuringaKey generateTuringaKey(const size_t keylength, const std::string& availableRotors, const size_t minCycle) {
+  if (keylength == 0 || keylength > MAX_KEYLENGTH) {
+    throw InvalidArgument("generateTuringaKey", std::to_string(keylength),
+                          "as key length, it has to be between 1 and " + std::to_string(MAX_KEYLENGTH));
+  }
   Byte* rotorShifts           = (Byte*) malloc(MAX_KEYLENGTH);
   const size_t numberOfRotors = availableRotors.length();
   duthomhas::csprng random;
-  for (size_t i = 0; i < MAX_KEYLENGTH; ++i) {
-    rotorShifts[i] = random();
+  if (minCycle > 0) {
+    drawRotorShifts(rotorShifts, minCycle, random);
+  }
+  else {
+    for (size_t i = 0; i < MAX_KEYLENGTH; ++i) {
+      rotorShifts[i] = random();
+    }
   }
   char* rotorNames = (char*) malloc(keylength);
   for (unsigned int i = 0; i < keylength; ++i) {
@@ -55,58 +96,225 @@ TuringaKey createStdKey() {
     generateRotor(VALID_ROT_NAMES.c_str());
     rotorNames = VALID_ROT_NAMES;
   }
-  return generateTuringaKey(STD_KEY_LENGTH, rotorNames);
+  TuringaKey key = generateTuringaKey(STD_KEY_LENGTH, rotorNames);
+  stampRotorHash(key, STD_ROT_DIR.c_str());
+  return key;
 }
 
-// encrypts/ decrypts the files
-void encrypt(Data& bytes, TuringaKey& key, const Byte* rotors) {
-  // maybe other numbers of threads would be more efficient
-  const size_t threadcount = std::thread::hardware_concurrency();  // number of logical processors
-  std::cout << timestamp(current_duration()) << threadcount << " logical processors detected.\n";
+void deriveChunkShifts(Byte* rotorShifts, const Byte* keyShifts, const uint64_t chunk) {
+  // words 0 - 7 are the key, words 8 and 9 the block counter and words 10 and 11 the nonce
+  uint32_t seed[12] = {0};
+  std::memcpy(&seed[0], keyShifts, MAX_KEYLENGTH);
+  std::memcpy(&seed[10], &chunk, sizeof(uint64_t));
+  ChaCha rng;
+  rng.init(seed);
+  rng.generate(rotorShifts, MAX_KEYLENGTH);
+}
+
+// loads the range, if the data isn't in place yet, encrypts/ decrypts it and stores the result
+static void encrypt_range(
+  Data& bytes, const RangeIO* io, const TuringaKey& key, const Byte* rotors, const CryptOptions& options,
+  const size_t begin, const size_t end) {
+  if (io != nullptr && io->load) {
+    io->load(bytes.bytes, begin, end);
+  }
+  encrypt_block(bytes, key, rotors, options, begin, end);
+  if (io != nullptr && io->store) {
+    io->store(bytes.bytes, begin, end);
+  }
+}
+
+// encrypts/ decrypts the part of a chunk inside bytes, which start at position offset of the data
+static void encrypt_chunk(
+  Data& bytes, const size_t offset, const RangeIO* io, TuringaKey key, const Byte* rotors,
+  const CryptOptions& options, const size_t chunkSize, const size_t chunk) {
+  Byte rotorShifts[MAX_KEYLENGTH];
+  deriveChunkShifts(rotorShifts, key.rotorShifts, chunk);
+  key.rotorShifts = rotorShifts;
+  // bytes may start inside the chunk
+  const size_t first = std::max(chunk * chunkSize, offset);
+  advance(rotorShifts, first - chunk * chunkSize);
+  encrypt_range(
+    bytes, io, key, rotors, options, first - offset, std::min((chunk + 1) * chunkSize - offset, bytes.size));
+}
+
+// encrypts/ decrypts bytes in the legacy format, the rotor state at the start of each task is found by walking the
+// rotate chain while the pool already works on the earlier tasks
+static void encrypt_legacy(
+  Data& bytes, const size_t offset, const RangeIO* io, const TuringaKey& key, const Byte* rotors,
+  const CryptOptions& options, ThreadPool& pool, const size_t taskSize, CheckpointCache& cache) {
+  const size_t tasks = (bytes.size + taskSize - 1) / taskSize;
+  std::vector<Byte> rotorShiftsAry(tasks * MAX_KEYLENGTH);
+
+  if (io != nullptr && io->load) {
+    // the start states only depend on the key and the positions, so they are walked in the background while all
+    // tasks already load their ranges and wait for their state afterwards
+    std::mutex mutex;
+    std::condition_variable progress;
+    size_t walked = 0;
+    std::thread walker([&]() {
+      for (size_t i = 0; i < tasks; ++i) {
+        cache.seek(rotorShiftsAry.data() + i * MAX_KEYLENGTH, offset + i * taskSize);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          walked = i + 1;
+        }
+        progress.notify_all();
+      }
+    });
+    for (size_t i = 0; i < tasks; ++i) {
+      const size_t begin = i * taskSize;
+      const size_t end   = std::min(begin + taskSize, bytes.size);
+      pool.submit([&, i, begin, end]() {
+        io->load(bytes.bytes, begin, end);
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          progress.wait(lock, [&walked, i]() { return walked > i; });
+        }
+        Byte* rotorShifts = rotorShiftsAry.data() + i * MAX_KEYLENGTH;
+        encrypt_block(
+          bytes, TuringaKey{key.direction, key.length, key.rotorNames, rotorShifts, key.fileShift}, rotors, options,
+          begin, end);
+        if (io->store) {
+          io->store(bytes.bytes, begin, end);
+        }
+      });
+    }
+    try {
+      pool.wait();
+    } catch (...) {
+      walker.join();
+      throw;
+    }
+    walker.join();
+    return;
+  }
 
-  size_t begin = 0, end;
-  end          = bytes.size / threadcount;
+  for (size_t i = 0; i < tasks; ++i) {
+    Byte* rotorShifts  = rotorShiftsAry.data() + i * MAX_KEYLENGTH;
+    const size_t begin = i * taskSize;
+    const size_t end   = std::min(begin + taskSize, bytes.size);
+    cache.seek(rotorShifts, offset + begin);
+    pool.submit([&bytes, io, &key, rotors, &options, rotorShifts, begin, end]() {
+      encrypt_range(
+        bytes, io, TuringaKey{key.direction, key.length, key.rotorNames, rotorShifts, key.fileShift}, rotors,
+        options, begin, end);
+    });
+  }
+  pool.wait();
+}
 
-  std::vector<std::thread> threads;
-  std::vector<Byte*> rotorShiftsAry(threadcount);
+// largest number of threads substituting bytes
+static size_t maxWorkers(const CryptOptions& options) {
+  const size_t workers = (options.threads != 0) ? options.threads : availableProcessors().count;
+  // in the pipelined mode every worker is paired with a stepping thread
+  return (options.mode == pipelined) ? std::max<size_t>(workers / 2, 1) : workers;
+}
 
-  // allocate memory for copying
-  for (size_t i = 0; i < threadcount; i++) {
-    rotorShiftsAry[i] = (Byte*) malloc(MAX_KEYLENGTH);
+WorkPlan planEncrypt(const size_t size, const TuringaKey& key, const CryptOptions& options, const FileHeader& header) {
+  if (header.version == chunked) {
+    // the chunks are the tasks
+    const size_t chunks = (size + header.chunkSize - 1) / header.chunkSize;
+    WorkPlan plan = planWork(size, key.length, std::min(maxWorkers(options), std::max<size_t>(chunks, 1)), false);
+    plan.taskSize = header.chunkSize;
+    return plan;
   }
+  return planWork(size, key.length, maxWorkers(options), true);
+}
 
-  std::memcpy(rotorShiftsAry[0], key.rotorShifts, MAX_KEYLENGTH);
+ThreadPool& cryptPool(const CryptOptions& options) {
+  // the calling thread takes part in the work
+  return threadPool(maxWorkers(options) - 1);
+}
 
-  for (size_t i = 0; i < threadcount - 1; ++i) {
-    // copy the key because rotate in encrypt changes rotorShifts
-    std::memcpy(rotorShiftsAry[i + 1], rotorShiftsAry[i], MAX_KEYLENGTH);
+void printCryptSetup(const CryptOptions& options) {
+  const ProcessorBudget& processors = availableProcessors();
+  std::cout << timestamp(current_duration()) << processors.installed << " logical processors detected, "
+            << processors.count << " available according to the " << processors.source << ".\n";
+  std::cout << timestamp(current_duration()) << "Using " << kernelName(KERNELS.kernel) << " kernel.\n";
+  if (options.mode == pipelined) {
+    std::cout << timestamp(current_duration()) << "Pipelined mode with up to " << maxWorkers(options)
+              << " pairs of stepping and substitution threads, " << options.ringDepth << " blocks of "
+              << options.blockSize << " positions each.\n";
+  }
+}
 
-    // start a thread
-    threads.push_back(std::thread(
-      encrypt_block, std::ref(bytes),
-      TuringaKey{key.direction, key.length, key.rotorNames, rotorShiftsAry[i], key.fileShift}, rotors, begin, end));
-    // prepair for next thread
-    for (size_t j = begin; j < end; ++j) {  // rotate to start of next thread
-      rotate(rotorShiftsAry[i + 1]);
+void encryptWindow(
+  Data& bytes, const size_t offset, const TuringaKey& key, const Byte* rotors, const CryptOptions& options,
+  const FileHeader& header, CheckpointCache* cache, const RangeIO* io) {
+  const size_t chunkSize  = (header.version == chunked) ? header.chunkSize : 1;
+  const size_t firstChunk = (header.version == chunked) ? offset / chunkSize : 0;
+  const size_t lastChunk  = (header.version == chunked) ? (offset + bytes.size + chunkSize - 1) / chunkSize : 0;
+  const WorkPlan plan     = planEncrypt(bytes.size, key, options, header);
+
+  if (plan.threads == 1) {
+    // small files are processed right here, without any threads
+    if (header.version == chunked) {
+      for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+        encrypt_chunk(bytes, offset, io, key, rotors, options, header.chunkSize, chunk);
+      }
+    }
+    else {
+      Byte rotorShifts[MAX_KEYLENGTH];
+      cache->seek(rotorShifts, offset);
+      encrypt_range(
+        bytes, io, TuringaKey{key.direction, key.length, key.rotorNames, rotorShifts, key.fileShift}, rotors,
+        options, 0, bytes.size);
     }
-    begin = end;
-    end += bytes.size / threadcount;
+    return;
   }
 
-  // encrypt the rest
-  encrypt_block(
-    bytes, TuringaKey{key.direction, key.length, key.rotorNames, rotorShiftsAry[threadcount - 1], key.fileShift},
-    rotors, begin, bytes.size);
+  ThreadPool& pool = cryptPool(options);
+  pool.limit(plan.threads);
+  if (header.version == chunked) {
+    // every chunk is a task, no task depends on the rotor state of another one
+    for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+      pool.submit([&bytes, offset, io, &key, rotors, &options, &header, chunk]() {
+        encrypt_chunk(bytes, offset, io, key, rotors, options, header.chunkSize, chunk);
+      });
+    }
+    pool.wait();
+  }
+  else {
+    encrypt_legacy(bytes, offset, io, key, rotors, options, pool, plan.taskSize, *cache);
+  }
+}
 
-  // collect all threads
-  for (std::thread& thr : threads) {
-    thr.join();
+// encrypts/ decrypts the files
+void encrypt(
+  Data& bytes, TuringaKey& key, const Byte* rotors, const CryptOptions& options, const FileHeader& header,
+  const RangeIO* io) {
+  printCryptSetup(options);
+  const WorkPlan plan = planEncrypt(bytes.size, key, options, header);
+  if (plan.threads == 1) {
+    std::cout << timestamp(current_duration()) << "Single threaded.\n";
+  }
+  else {
+    std::cout << timestamp(current_duration()) << "Using " << plan.threads << " threads for an estimated "
+              << plan.duration << " s of work";
+    if (header.version != chunked) {
+      std::cout << " in tasks of " << plan.taskSize << " bytes";
+    }
+    std::cout << ".\n";
   }
 
-  // free all memory
-  for (Byte*& rotShi : rotorShiftsAry) {
-    free(rotShi);
+  const double start = current_duration();
+  if (header.version == chunked) {
+    encryptWindow(bytes, 0, key, rotors, options, header, nullptr, io);
   }
+  else {
+    // the cache provides the rotor state at the start of each task
+    CheckpointCache cache(key.rotorShifts, options);
+    encryptWindow(bytes, 0, key, rotors, options, header, &cache, io);
+    if (plan.threads > 1) {
+      cache.save();
+      cache.printStats();
+    }
+  }
+  if (plan.threads > 1) {
+    cryptPool(options).printStats();
+  }
+  printThroughput(bytes.size, current_duration() - start);
 
   if (key.direction == 0) {
     std::cout << timestamp(current_duration()) << "File has been encrypted.\n";
@@ -116,30 +324,21 @@ void encrypt(Data& bytes, TuringaKey& key, const Byte* rotors) {
   }
 }
 
-void encrypt_block(Data& bytes, TuringaKey key, const Byte* rotors, const size_t begin, const size_t end) {
-  const size_t keylength = key.length;
-
-  // encryption
-  if (key.direction == encryption) {
-    for (size_t i = begin; i < end; ++i) {
-      Byte tmp = bytes.bytes[i];
-      for (size_t i = 0; i < keylength; ++i) {
-        tmp = rotors[256 * i + ((tmp + key.rotorShifts[i]) % 256)];
-      }
-      bytes.bytes[i] = tmp;
-      rotate(key.rotorShifts);
-    }
+void printThroughput(const size_t size, const double duration) {
+  std::cout << timestamp(current_duration()) << "Processed " << size << " bytes in " << duration << " s";
+  if (duration > 0) {
+    std::cout << " (" << size / duration / 1e6 << " MB/s)";
   }
+  std::cout << ".\n";
+}
 
-  // decryption
-  else if (key.direction == decryption) {
-    for (size_t i = begin; i < end; ++i) {
-      Byte tmp = bytes.bytes[i];
-      for (size_t i = 0; i < keylength; ++i) {
-        tmp = rotors[256 * i + tmp] - key.rotorShifts[keylength - 1 - i];
-      }
-      bytes.bytes[i] = tmp;
-      rotate(key.rotorShifts);
-    }
+void encrypt_block(
+  Data& bytes, TuringaKey key, const Byte* rotors, const CryptOptions& options, const size_t begin,
+  const size_t end) {
+  if (options.mode == pipelined) {
+    substitutePipelined(bytes.bytes + begin, end - begin, key, rotors, options.ringDepth, options.blockSize);
+  }
+  else {
+    substitute(bytes.bytes + begin, end - begin, key, rotors);
   }
 }
@@ -0,0 +1,81 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "workplan.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "constants.hpp"
+#include "kernels.hpp"
+#include "rotate.hpp"
+#include "types.hpp"
+
+// seconds needed to substitute CALIBRATION_BYTES bytes with a key of the given length
+static double measureSubstitute(const size_t keylength, const Byte* rotors) {
+  std::vector<Byte> bytes(CALIBRATION_BYTES);
+  Byte rotorShifts[MAX_KEYLENGTH] = {0};
+  char rotorNames[MAX_KEYLENGTH]  = {0};
+  const TuringaKey key{encryption, keylength, rotorNames, rotorShifts, 0};
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  KERNELS.substitute(bytes.data(), bytes.size(), key, rotors);
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// seconds needed to walk CALIBRATION_BYTES positions of the rotate chain
+static double measureAdvance() {
+  Byte rotorShifts[MAX_KEYLENGTH] = {0};
+  const auto start                = std::chrono::high_resolution_clock::now();
+  advance(rotorShifts, CALIBRATION_BYTES);
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+const CostModel& costModel() {
+  static const CostModel model = []() {
+    const std::vector<Byte> rotors(ROTOR_MEMORY);
+    // the first run warms up caches and clocks
+    measureSubstitute(MAX_KEYLENGTH, rotors.data());
+    const double shortKey = measureSubstitute(1, rotors.data()) / CALIBRATION_BYTES;
+    const double longKey  = measureSubstitute(MAX_KEYLENGTH, rotors.data()) / CALIBRATION_BYTES;
+    const double perRotor = std::max((longKey - shortKey) / (MAX_KEYLENGTH - 1), 0.0);
+    return CostModel{std::max(shortKey - perRotor, 0.0), perRotor, measureAdvance() / CALIBRATION_BYTES};
+  }();
+  return model;
+}
+
+WorkPlan planWork(const size_t size, const size_t keylength, const size_t maxThreads, const bool walk) {
+  if (size < FAST_PATH_BYTES || maxThreads <= 1) {
+    return WorkPlan{1, size, 0};
+  }
+
+  const CostModel& model = costModel();
+  const double perByte   = model.perByte + keylength * model.perRotor;
+  const double duration  = size * perByte;
+
+  // every thread should get a few tasks, every task should outweigh its overhead
+  size_t threads = std::clamp<size_t>(duration / (MIN_TASK_DURATION * TASKS_PER_THREAD), 1, maxThreads);
+  if (walk && model.perStep > 0) {
+    // the calling thread walks the chain while the others substitute
+    threads = std::min<size_t>(threads, std::ceil(perByte / model.perStep) + 1);
+  }
+  const size_t taskSize = std::max<size_t>(
+    (size + threads * TASKS_PER_THREAD - 1) / (threads * TASKS_PER_THREAD), MIN_TASK_DURATION / perByte);
+  return WorkPlan{threads, taskSize, duration};
+}
@@ -0,0 +1,73 @@
+/*
+ * Turinga is a simple symmetric encryption scheme based on ideas from enigma.
+ * Copyright (C) 2022  Mathemalsky, MilchRatchet
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+
+#include "testrotate.hpp"
+
+// checks brentCycle on the sequence 0, 1, ..., tail + length - 1, tail, tail + 1, ... with a known tail and cycle
+static bool check(const size_t tail, const size_t length, const size_t maxIter) {
+  const auto next = [tail, length](const size_t x) { return (x + 1 < tail + length) ? x + 1 : tail; };
+  const auto walk = [next](size_t& hare, const size_t steps, const size_t& target) {
+    for (size_t step = 0; step < steps; ++step) {
+      hare = next(hare);
+      if (hare == target) {
+        return step + 1;
+      }
+    }
+    return steps;
+  };
+  const auto findTail = [next](const size_t cycle) {
+    size_t x = 0, y = 0;
+    for (size_t i = 0; i < cycle; ++i) {
+      y = next(y);
+    }
+    size_t found = 0;
+    for (; x != y; ++found) {
+      x = next(x);
+      y = next(y);
+    }
+    return found;
+  };
+
+  std::atomic<size_t> progress(0);
+  const CycleInfo cycle = brentCycle(size_t(0), maxIter, walk, findTail, progress);
+  const bool expected   = (tail + length <= maxIter);
+  const bool correct    = (cycle.found == expected) && (!expected || (cycle.tail == tail && cycle.length == length));
+  if (!correct) {
+    std::cout << "tail " << tail << ", length " << length << ", maxIter " << maxIter << ": found " << cycle.found
+              << ", tail " << cycle.tail << ", length " << cycle.length << "\n";
+  }
+  return correct;
+}
+
+int main() {
+  size_t failures = 0, checks = 0;
+  for (const size_t tail : {0, 1, 3, 100, 1000, 4097}) {
+    for (const size_t length : {1, 2, 7, 256, 1000, 5000}) {
+      const size_t n = tail + length;
+      for (const size_t maxIter : {n - 1, n, n + 1, 2 * n, 3 * n}) {
+        failures += !check(tail, length, maxIter);
+        ++checks;
+      }
+    }
+  }
+  std::cout << checks - failures << " of " << checks << " cycle searches correct\n";
+  return (failures == 0) ? 0 : 1;
+}